@@ -0,0 +1,198 @@
+// bplustree_template.h - compile-time specialized B+ tree operations
+//
+// Header template: include it once per key type with these macros defined
+//   BPT_NAME                 suffix for the generated functions (e.g. IntTree -> searchIntTree)
+//   BPT_KEY_T                key type, stored by value in the node's key slots
+//   BPT_KEY_LESS(a, b)       a < b for two BPT_KEY_T values
+//   BPT_KEY_EQUAL(a, b)      a == b for two BPT_KEY_T values
+// Optional:
+//   BPT_NO_SEARCH            skip search<NAME>, for trees that are only walked with cursors
+// The macros are #undef'd at the end so the header can be included again.
+//
+// The generated functions work on the shared BPlusTree/BPlusTreeNode layout (inline keys,
+// node slabs from the tree's arena), so a tree built by createBPlusTree with
+// key_size == sizeof(BPT_KEY_T) can be used with both the generic and the specialized API.
+// The comparator and key size are compile-time constants here: key loads, shifts and splits
+// are typed copies instead of memcpy by tree->key_stride, comparisons are inlined instead of
+// going through tree->compare, and keys are passed by value so no key is ever allocated.
+// The only indirect call left is the runtime-selected SIMD kernel (tree->node_search).
+//
+// Generated:
+//   int   nodeLowerBound<NAME>(const BPlusTreeNode *node, const BPT_KEY_T *key, bool upper)
+//   BPlusTreeNode* findLeaf<NAME>(BPlusTree *tree, const BPT_KEY_T *key, BPlusTreeNode **path, int *depth)
+//   void* search<NAME>(BPlusTree *tree, BPT_KEY_T key)   (unless BPT_NO_SEARCH)
+//   bool  insert<NAME>(BPlusTree *tree, BPT_KEY_T key, void *data_ptr)
+// Deletes go through the generic deleteBPlusTree, which works on the same nodes.
+
+#if !defined(BPT_NAME) || !defined(BPT_KEY_T) || !defined(BPT_KEY_LESS) || !defined(BPT_KEY_EQUAL)
+#error "bplustree_template.h needs BPT_NAME, BPT_KEY_T, BPT_KEY_LESS and BPT_KEY_EQUAL"
+#endif
+
+#ifndef BPT_TEMPLATE_COMMON
+#define BPT_TEMPLATE_COMMON
+#define BPT_CONCAT_(a, b) a##b
+#define BPT_CONCAT(a, b) BPT_CONCAT_(a, b)
+#define BPT_FN(prefix) BPT_CONCAT(prefix, BPT_NAME)
+#define BPT_MAX_HEIGHT 64 // Root-to-leaf path bound: t >= 2 gives fewer than 64 levels for any key count
+#endif
+
+#define BPT_KEYS(node) ((BPT_KEY_T*)(node)->keys)
+
+// First index whose key is >= key (or > key when `upper`), node->n if none
+static inline int BPT_FN(nodeLowerBound)(const BPlusTreeNode *node, const BPT_KEY_T *key, bool upper) {
+    if (node->tree->node_search) return node->tree->node_search(node->keys, node->n, key, upper);
+    const BPT_KEY_T *keys = (const BPT_KEY_T*)node->keys;
+    int lo = 0, hi = node->n;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (BPT_KEY_LESS(keys[mid], *key) || (upper && BPT_KEY_EQUAL(keys[mid], *key))) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+// Descends to the leaf for key. When path is given it receives the internal nodes visited
+// (root first) and *depth their count, so inserts can walk back up without searching for parents.
+static inline BPlusTreeNode* BPT_FN(findLeaf)(BPlusTree *tree, const BPT_KEY_T *key, BPlusTreeNode **path, int *depth) {
+    BPlusTreeNode *node = tree->root;
+    int d = 0;
+    while (node && !node->is_leaf) {
+        if (path) path[d++] = node;
+        node = node->node_type.internal.C[BPT_FN(nodeLowerBound)(node, key, true)];
+    }
+    if (depth) *depth = d;
+    return node;
+}
+
+#ifndef BPT_NO_SEARCH
+// Returns the data stored under key, or NULL
+void* BPT_FN(search)(BPlusTree *tree, BPT_KEY_T key) {
+    if (!tree || !tree->root) return NULL;
+    BPlusTreeNode *leaf = BPT_FN(findLeaf)(tree, &key, NULL, NULL);
+    if (!leaf) return NULL;
+    int i = BPT_FN(nodeLowerBound)(leaf, &key, false);
+    if (i < leaf->n && BPT_KEY_EQUAL(BPT_KEYS(leaf)[i], key)) return leaf->node_type.leaf.data_pointers[i];
+    return NULL;
+}
+#endif
+
+// Inserts key/data_ptr. The tree takes ownership of data_ptr; on a duplicate key or a failed
+// allocation the data is released with tree->free_data, as insertBPlusTree does.
+bool BPT_FN(insert)(BPlusTree *tree, BPT_KEY_T key, void *data_ptr) {
+    if (!tree || !tree->root || !data_ptr) {
+        logError("Error: Invalid arguments for specialized B+ tree insert.\n");
+        return false;
+    }
+    const int max_keys = 2 * tree->t - 1;
+    BPlusTreeNode *path[BPT_MAX_HEIGHT];
+    int depth = 0;
+    BPlusTreeNode *leaf = BPT_FN(findLeaf)(tree, &key, path, &depth);
+    if (!leaf) {
+        logError("Error: Could not find leaf node for insertion.\n");
+        if (tree->free_data) tree->free_data(data_ptr);
+        return false;
+    }
+    int pos = BPT_FN(nodeLowerBound)(leaf, &key, false);
+    if (pos < leaf->n && BPT_KEY_EQUAL(BPT_KEYS(leaf)[pos], key)) {
+        logError("Error: Duplicate key insertion attempted.\n");
+        if (tree->free_data) tree->free_data(data_ptr);
+        return false;
+    }
+
+    BPlusTreeNode *target = leaf;
+    BPT_KEY_T separator;
+    BPlusTreeNode *right = NULL;
+    if (leaf->n == max_keys) {
+        // Split before inserting: keys [t, 2t-1) move right, the right leaf's first key goes up
+        right = createBPlusTreeNode(tree, true);
+        if (!right) {
+            if (tree->free_data) tree->free_data(data_ptr);
+            return false;
+        }
+        int split = tree->t, moved = max_keys - split;
+        memcpy(BPT_KEYS(right), BPT_KEYS(leaf) + split, moved * sizeof(BPT_KEY_T));
+        memcpy(right->node_type.leaf.data_pointers, leaf->node_type.leaf.data_pointers + split, moved * sizeof(void*));
+        memset(leaf->node_type.leaf.data_pointers + split, 0, moved * sizeof(void*));
+        right->n = moved;
+        leaf->n = split;
+        right->node_type.leaf.next = leaf->node_type.leaf.next;
+        if (right->node_type.leaf.next) right->node_type.leaf.next->node_type.leaf.prev = right;
+        leaf->node_type.leaf.next = right;
+        right->node_type.leaf.prev = leaf;
+        separator = BPT_KEYS(right)[0];
+        if (pos > split) { // pos == split means key < separator: it ends the left leaf
+            target = right;
+            pos -= split;
+        }
+    }
+    BPT_KEY_T *keys = BPT_KEYS(target);
+    void **data = target->node_type.leaf.data_pointers;
+    memmove(keys + pos + 1, keys + pos, (target->n - pos) * sizeof(BPT_KEY_T));
+    memmove(data + pos + 1, data + pos, (target->n - pos) * sizeof(void*));
+    keys[pos] = key;
+    data[pos] = data_ptr;
+    target->n++;
+
+    // Propagate splits up the recorded path
+    BPlusTreeNode *left = leaf;
+    while (right) {
+        if (depth == 0) {
+            BPlusTreeNode *new_root = createBPlusTreeNode(tree, false);
+            if (!new_root) {
+                logError(" Error: Could not allocate new root. Tree is inconsistent.\n");
+                return false;
+            }
+            BPT_KEYS(new_root)[0] = separator;
+            new_root->node_type.internal.C[0] = left;
+            new_root->node_type.internal.C[1] = right;
+            new_root->n = 1;
+            tree->root = new_root;
+            break;
+        }
+        BPlusTreeNode *parent = path[--depth];
+        int slot = BPT_FN(nodeLowerBound)(parent, &separator, true);
+        BPlusTreeNode *parent_right = NULL;
+        BPT_KEY_T pushed = separator;
+        BPlusTreeNode *dest = parent;
+        if (parent->n == max_keys) {
+            // Key t-1 moves up; keys after it and children from t onwards move right
+            parent_right = createBPlusTreeNode(tree, false);
+            if (!parent_right) {
+                logError("Error: Internal node split failed. Insertion incomplete.\n");
+                return false;
+            }
+            int t = tree->t;
+            pushed = BPT_KEYS(parent)[t - 1];
+            memcpy(BPT_KEYS(parent_right), BPT_KEYS(parent) + t, (max_keys - t) * sizeof(BPT_KEY_T));
+            memcpy(parent_right->node_type.internal.C, parent->node_type.internal.C + t, t * sizeof(BPlusTreeNode*));
+            memset(parent->node_type.internal.C + t, 0, t * sizeof(BPlusTreeNode*));
+            parent_right->n = max_keys - t;
+            parent->n = t - 1;
+            if (BPT_KEY_LESS(separator, pushed)) {
+                dest = parent;
+            } else {
+                dest = parent_right;
+                slot -= t;
+            }
+        }
+        BPT_KEY_T *dkeys = BPT_KEYS(dest);
+        BPlusTreeNode **children = dest->node_type.internal.C;
+        memmove(dkeys + slot + 1, dkeys + slot, (dest->n - slot) * sizeof(BPT_KEY_T));
+        memmove(children + slot + 2, children + slot + 1, (dest->n - slot) * sizeof(BPlusTreeNode*));
+        dkeys[slot] = separator;
+        children[slot + 1] = right;
+        dest->n++;
+
+        left = parent;
+        right = parent_right;
+        separator = pushed;
+    }
+    return true;
+}
+
+#undef BPT_KEYS
+#undef BPT_NAME
+#undef BPT_KEY_T
+#undef BPT_KEY_LESS
+#undef BPT_KEY_EQUAL
+#undef BPT_NO_SEARCH
@@ -0,0 +1,25 @@
+// parking_alloc_count.h - allocation counter build, private to parking_core.c and the menu
+//
+// With -DPARKING_COUNT_ALLOCS every malloc-family call in the files that include this header goes
+// through a counting wrapper (defined in parking_core.c), and each entry/exit logs how many heap
+// allocations it made, which shows the steady-state gate path allocates nothing. Not part of
+// parking_core.h, so programs linking libparking keep their own allocator calls. Include it after
+// every other header.
+
+#ifndef PARKING_ALLOC_COUNT_H
+#define PARKING_ALLOC_COUNT_H
+
+#ifdef PARKING_COUNT_ALLOCS
+#include <stdlib.h>
+extern size_t alloc_calls;
+void* countedMalloc(size_t size);
+void* countedCalloc(size_t count, size_t size);
+void* countedRealloc(void *ptr, size_t size);
+void* countedAlignedAlloc(size_t alignment, size_t size);
+#define malloc(size) countedMalloc(size)
+#define calloc(count, size) countedCalloc(count, size)
+#define realloc(ptr, size) countedRealloc(ptr, size)
+#define aligned_alloc(alignment, size) countedAlignedAlloc(alignment, size)
+#endif
+
+#endif // PARKING_ALLOC_COUNT_H
@@ -0,0 +1,3491 @@
+// parking_core.c - Smart Car Parking System engine (libparking), see parking_core.h
+
+#include <stdlib.h>
+
+#ifdef PARKING_COUNT_ALLOCS
+// Counting wrappers, defined before parking_alloc_count.h redirects the malloc family to them
+size_t alloc_calls = 0;
+void* countedMalloc(size_t size) { alloc_calls++; return malloc(size); }
+void* countedCalloc(size_t count, size_t size) { alloc_calls++; return calloc(count, size); }
+void* countedRealloc(void *ptr, size_t size) { alloc_calls++; return realloc(ptr, size); }
+void* countedAlignedAlloc(size_t alignment, size_t size) { alloc_calls++; return aligned_alloc(alignment, size); }
+#endif
+
+#include "parking_core.h"
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sched.h>
+#include <stddef.h>
+#if PARKING_X86_SIMD
+#include <immintrin.h>
+#endif
+#include "parking_alloc_count.h" // Last: redirects the malloc family in counter builds
+
+// --- Global Output File Pointer ---
+FILE *outputFile = NULL;
+
+const char* membership_strings[] = {"None", "Premium", "Gold"};
+
+ParkingClock parkingClock = {PARKING_CLOCK_WALL, 0};
+LogLevel logLevel = LOG_INFO;
+
+// --- Log Writer State ---
+// Single ring shared by every producer. head/tail are byte counters that only grow; the writer
+// owns tail, producers own head. The mutex/condvars are only used to sleep and wake, never to
+// copy data: a producer takes the mutex only at an operation boundary, when the ring is full or
+// when a size threshold is crossed.
+typedef struct {
+    char *ring;
+    size_t capacity;          // Power of two
+    _Alignas(CACHE_LINE_SIZE) _Atomic size_t head;    // Bytes produced
+    _Alignas(CACHE_LINE_SIZE) _Atomic size_t tail;    // Bytes written to the sink (own line: the writer stores it)
+    _Alignas(CACHE_LINE_SIZE) _Atomic size_t flushed; // head value covered by the last fflush
+    atomic_flag producer_lock;
+    bool running;
+    bool wake_requested;      // Guarded by mutex
+    bool stop;                // Guarded by mutex
+    LogFlushPolicy policy;
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t wake;      // Writer waits here
+    pthread_cond_t drained;   // Producers / logFlush wait here
+} LogWriter;
+
+LogWriter logWriter = {.producer_lock = ATOMIC_FLAG_INIT, .mutex = PTHREAD_MUTEX_INITIALIZER,
+                       .wake = PTHREAD_COND_INITIALIZER, .drained = PTHREAD_COND_INITIALIZER};
+char logSinkBuffer[LOG_SINK_BUFFER_BYTES]; // Static: outputFile may still use it after logStop
+
+// --- Specialized B+ Tree Instantiations ---
+#define BPT_NAME PlateTree
+#define BPT_KEY_T PlateKey
+#define BPT_KEY_LESS(a, b) ((a).hi < (b).hi || ((a).hi == (b).hi && (a).lo < (b).lo))
+#define BPT_KEY_EQUAL(a, b) ((a).hi == (b).hi && (a).lo == (b).lo)
+#include "bplustree_template.h"
+
+#define BPT_NAME AmountTree
+#define BPT_KEY_T AmountKey
+#define BPT_KEY_LESS(a, b) ((a).amount > (b).amount || ((a).amount == (b).amount && \
+                            ((a).plate.hi < (b).plate.hi || ((a).plate.hi == (b).plate.hi && (a).plate.lo < (b).plate.lo))))
+#define BPT_KEY_EQUAL(a, b) ((a).amount == (b).amount && (a).plate.hi == (b).plate.hi && (a).plate.lo == (b).plate.lo)
+#define BPT_NO_SEARCH // The amount index is only range-scanned
+#include "bplustree_template.h"
+
+// --- Helper Function Implementations ---
+void safe_strcpy(char *dest, const char *src, size_t dest_size) {
+    if (!dest || !src || dest_size == 0) return;
+    strncpy(dest, src, dest_size - 1);
+    dest[dest_size - 1] = '\0'; // Ensure null termination
+}
+
+void formatTime(time_t rawtime, char* buffer, size_t buffer_size) {
+    if (!buffer || buffer_size == 0) return;
+    if (rawtime == 0) {
+        safe_strcpy(buffer, "N/A", buffer_size);
+        return;
+    }
+    struct tm * timeinfo;
+    timeinfo = localtime(&rawtime);
+    if (timeinfo) {
+        strftime(buffer, buffer_size, "%Y-%m-%d %H:%M:%S", timeinfo);
+    } else {
+        safe_strcpy(buffer, "Invalid Time", buffer_size);
+    }
+}
+
+// Parses "DD-MM-YYYY", "HH:MM", "AM/PM" into time_t
+time_t parseDateTimeString(const char* date_str, const char* time_str, const char* ampm_str) {
+    if (!date_str || !time_str || !ampm_str ||
+        strcmp(date_str, "none") == 0 || strcmp(time_str, "none") == 0 ||
+        strcmp(ampm_str, "none") == 0 || strcmp(ampm_str, "nonnone") == 0) { // Handle "none" and typo
+        return 0; 
+    }
+
+    struct tm t = {0};
+    int hour = 0, min = 0;
+
+    if (sscanf(date_str, "%d-%d-%d", &t.tm_mday, &t.tm_mon, &t.tm_year) == 3) {
+        if (t.tm_year < 1900) { 
+             fprintf(stderr, "Warning: Suspiciously old year (%d) parsed from file for date %s.\n", t.tm_year, date_str);
+             // Allow it for now, but mktime might fail later if year is too small
+        }
+        t.tm_mon -= 1; // struct tm months are 0-11
+        t.tm_year -= 1900; 
+    } else {
+        fprintf(stderr, " Invalid date format '%s' in input file.\n", date_str);
+        return 0;
+    }
+
+    if (sscanf(time_str, "%d:%d", &hour, &min) == 2) {
+        if (hour < 0 || hour > 23 || min < 0 || min > 59) { 
+             fprintf(stderr, " Invalid time values (%d:%d) parsed from file for time %s.\n", hour, min, time_str);
+             // Allow conversion attempt, mktime might handle/adjust
+        }
+        t.tm_min = min;
+    } else {
+         fprintf(stderr, " Invalid time format '%s' in input file.\n", time_str);
+        return 0; 
+    }
+
+    if (hour < 1 || hour > 12) {
+         fprintf(stderr, "Error: Hour (%d) out of 1-12 range for AM/PM format in time '%s'. Assuming 12-hour format.\n", hour, time_str);
+         // Attempt to correct common errors, e.g., 0 PM -> 12 PM? No, just proceed.
+    }
+
+    if (strcasecmp(ampm_str, "PM") == 0 && hour != 12) {
+        hour += 12;
+    } else if (strcasecmp(ampm_str, "AM") == 0 && hour == 12) { // Midnight case (12 AM -> 00:xx)
+        hour = 0;
+    } else if (strcasecmp(ampm_str, "AM") != 0 && strcasecmp(ampm_str, "PM") != 0) {
+         fprintf(stderr, " Invalid AM/PM designator '%s' in input file.\n", ampm_str);
+         return 0;
+    }
+    // Final check on adjusted hour
+    if (hour < 0 || hour > 23) {
+         fprintf(stderr, "Error: Calculated hour (%d) is invalid after AM/PM adjustment.\n", hour);
+         return 0;
+    }
+    t.tm_hour = hour;
+    time_t result = localDateTimeToEpoch(t.tm_year + 1900, t.tm_mon + 1, t.tm_mday, t.tm_hour, t.tm_min, 0);
+    if (result == -1) {
+         fprintf(stderr, "Error: mktime failed to convert date/time: %s %s %s\n", date_str, time_str, ampm_str);
+         return 0;
+    }
+    return result;
+}
+
+// Parses "YYYY-MM-DD HH:MM:SS" (24-hour) from user input using sscanf
+time_t parseUserInputDateTime(const char* datetime_str) {
+    if (!datetime_str) return 0;
+    int year, month, day, hour, min, sec;
+    if (sscanf(datetime_str, "%d-%d-%d %d:%d:%d",   &year, &month, &day, &hour, &min, &sec) == 6) {
+        if (year < 1900 || month < 1 || month > 12 || day < 1 || day > 31 ||
+            hour < 0 || hour > 23 || min < 0 || min > 59 || sec < 0 || sec > 59)
+        {
+            fprintf(stderr, "Error: Invalid date/time component value in input '%s'.\n", datetime_str);
+            return 0;
+        }
+
+        time_t result = localDateTimeToEpoch(year, month, day, hour, min, sec);
+        if (result == (time_t)-1) {
+             fprintf(stderr, "Error: mktime failed to convert user input '%s'. Date/time likely invalid.\n", datetime_str);
+             return 0;
+        }
+        return result;
+
+    } else {
+        fprintf(stderr, "Error: Invalid date/time format provided by user. Expected YYYY-MM-DD HH:MM:SS, got '%s'.\n", datetime_str);
+        return 0; 
+    }
+}
+
+// --- Local Time Conversion ---
+// mktime re-reads timezone state on every call, which dominated the initial load. Within a day
+// that has no UTC offset change, local time is UTC minus a fixed offset, so the offset is looked
+// up once per civil date (with mktime at midnight) and reused for every time on that date.
+// Days that contain a DST or zone transition keep calling mktime, so results are identical.
+// The cache is per thread and assumes TZ does not change while the program runs.
+typedef struct {
+    int64_t day;      // daysFromCivil of the cached date
+    int64_t offset;   // UTC seconds minus local seconds at midnight
+    bool use_mktime;  // The date has a transition
+    bool valid;
+} DateCacheEntry;
+
+_Thread_local DateCacheEntry dateCache[DATE_CACHE_SIZE];
+
+// Howard Hinnant's days_from_civil
+int64_t daysFromCivil(int year, int month, int day) {
+    int64_t y = (int64_t)year - (month <= 2);
+    int64_t era = (y >= 0 ? y : y - 399) / 400;
+    int64_t yoe = y - era * 400;                                          // [0, 399]
+    int64_t doy = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1; // [0, 365]
+    int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;                  // [0, 146096]
+    return era * 146097 + doe - 719468;
+}
+
+int daysInMonth(int year, int month) {
+    static const int days[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    if (month == 2 && year % 4 == 0 && (year % 100 != 0 || year % 400 == 0)) return 29;
+    return days[month - 1];
+}
+
+time_t mktimeLocal(int year, int month, int day, int hour, int min, int sec) {
+    struct tm t = {0};
+    t.tm_year = year - 1900;
+    t.tm_mon = month - 1; // struct tm months are 0-11
+    t.tm_mday = day;
+    t.tm_hour = hour;
+    t.tm_min = min;
+    t.tm_sec = sec;
+    t.tm_isdst = -1; // Let mktime determine DST
+    return mktime(&t);
+}
+
+// Local civil time to epoch seconds; returns exactly what mktimeLocal would
+time_t localDateTimeToEpoch(int year, int month, int day, int hour, int min, int sec) {
+    if (year < 1900 || month < 1 || month > 12 || day < 1 || day > daysInMonth(year, month) ||
+        hour < 0 || hour > 23 || min < 0 || min > 59 || sec < 0 || sec > 59) {
+        return mktimeLocal(year, month, day, hour, min, sec); // Let mktime normalise
+    }
+    int64_t days = daysFromCivil(year, month, day);
+    DateCacheEntry *entry = &dateCache[(uint64_t)days & (DATE_CACHE_SIZE - 1)];
+    if (!entry->valid || entry->day != days) {
+        struct tm t = {0};
+        t.tm_year = year - 1900;
+        t.tm_mon = month - 1;
+        t.tm_mday = day;
+        t.tm_isdst = -1;
+        time_t midnight = mktime(&t);
+        bool midnight_exists = midnight != -1 && t.tm_hour == 0 && t.tm_min == 0 && t.tm_mday == day;
+        time_t next_midnight = mktimeLocal(year, month, day + 1, 0, 0, 0);
+        entry->day = days;
+        entry->offset = days * 86400 - (int64_t)midnight;
+        entry->use_mktime = !midnight_exists || next_midnight - midnight != 86400;
+        entry->valid = true;
+    }
+    if (entry->use_mktime) return mktimeLocal(year, month, day, hour, min, sec);
+    return (time_t)(days * 86400 + hour * 3600 + min * 60 + sec - entry->offset);
+}
+
+// Removes leading/trailing whitespace
+char *trim_whitespace(char *str) {
+    if (!str) return NULL;
+    char *end;
+    while (isspace((unsigned char)*str)) str++;
+
+    if (*str == 0) // All spaces?
+        return str;
+
+    // Trim trailing space
+    end = str + strlen(str) - 1;
+    while (end > str && isspace((unsigned char)*end)) end--;
+
+    // Write new null terminator character
+    end[1] = '\0';
+    return str;
+}
+
+// --- Comparison and Freeing Functions ---
+
+int compare_vehicle_keys(const void *key1, const void *key2) {
+    // check for NULL keys
+    if (!key1 && !key2) return 0;
+    if (!key1) return -1; // Treat NULL as less than non-NULL
+    if (!key2) return 1;
+    // Two word compares instead of a byte-by-byte strcmp
+    const PlateKey *plate1 = (const PlateKey*)key1;
+    const PlateKey *plate2 = (const PlateKey*)key2;
+    if (plate1->hi != plate2->hi) return plate1->hi < plate2->hi ? -1 : 1;
+    if (plate1->lo != plate2->lo) return plate1->lo < plate2->lo ? -1 : 1;
+    return 0;
+}
+
+int compare_space_keys(const void *key1, const void *key2) {
+    // check for NULL keys
+    if (!key1 && !key2) return 0;
+    if (!key1) return -1;
+    if (!key2) return 1;
+    int id1 = *(const int*)key1;
+    int id2 = *(const int*)key2;
+    if (id1 < id2) return -1;
+    if (id1 > id2) return 1;
+    return 0;
+}
+
+// Larger amounts first, then plate order (see AmountKey)
+int compare_amount_keys(const void *key1, const void *key2) {
+    if (!key1 && !key2) return 0;
+    if (!key1) return -1;
+    if (!key2) return 1;
+    const AmountKey *a = (const AmountKey*)key1;
+    const AmountKey *b = (const AmountKey*)key2;
+    if (a->amount != b->amount) return a->amount > b->amount ? -1 : 1;
+    return compare_vehicle_keys(&a->plate, &b->plate);
+}
+
+void free_vehicle_key(void *key) {
+    free(key); // Free the allocated PlateKey
+}
+
+void free_space_key(void *key) {
+    free(key); // Free the allocated int pointer
+}
+
+void free_vehicle_data(void *data) {
+    free(data); // Free the Vehicle struct
+}
+
+void free_space_data(void *data) {
+    free(data); // Free the ParkingSpace struct
+}
+
+PlateKey makePlateKey(const char* vnum) {
+    unsigned char padded[PLATE_KEY_SIZE] = {0};
+    size_t len = vnum ? strlen(vnum) : 0;
+    memcpy(padded, vnum, len < PLATE_KEY_SIZE ? len : PLATE_KEY_SIZE); // vehicle_number holds at most 14 chars
+    PlateKey key = {0, 0};
+    for (int i = 0; i < 8; i++) { // Big-endian: first character is the most significant byte
+        key.hi = (key.hi << 8) | padded[i];
+        key.lo = (key.lo << 8) | padded[8 + i];
+    }
+    return key;
+}
+
+// Looks a vehicle up by its number. The plate is packed into a stack PlateKey and borrowed by
+// searchPlateTree, so the entry/exit path never allocates a search key.
+Vehicle* lookupVehicle(BPlusTree *vehicleTree, const char *vehicle_num) {
+    if (!vehicle_num) return NULL;
+    return searchPlateTree(vehicleTree, makePlateKey(vehicle_num));
+}
+
+void* create_vehicle_key(const char* vnum) {
+    if (!vnum) return NULL;
+    PlateKey *key = malloc(sizeof(PlateKey));
+    if (key) {
+        *key = makePlateKey(vnum);
+    } else {
+     //   perror(" Failed to allocate vehicle key");
+        logError(" Failed to allocate memory for vehicle key '%s'.\n", vnum);
+        logFlush(); //  make sure the message reaches the log
+       // exit(EXIT_FAILURE); // Critical error
+    }
+    return key;
+}
+
+void* create_space_key(int space_id) {
+    int *key = malloc(sizeof(int));
+    if (key) {
+        *key = space_id;
+    } else {
+      //   perror(" Failed to allocate space key");
+         logError(" Failed to allocate memory for space key %d. Exiting.\n", space_id);
+         logFlush();
+        // exit(EXIT_FAILURE); // Critical error
+    }
+    return key;
+}
+
+
+// --- B+ Tree Core Implementations ---
+BPlusTreeNode* createBPlusTreeNode(BPlusTree *tree, bool is_leaf) {
+    BPlusTreeNode *node = nodeArenaAlloc(&tree->arena);
+    if (!node) {
+    //    perror(" Failed to allocate B+ Tree node");
+        logError(" Failed to allocate B+ Tree node.\n");
+        return NULL;
+    }
+    node->is_leaf = is_leaf;
+    node->n = 0;
+    node->tree = tree;
+
+    // The slab holds the header, then one cache-line aligned block: key slots (max 2t-1)
+    // followed by the data pointers (max 2t-1, leaf) or child pointers (max 2t, internal),
+    // so a node search touches contiguous memory instead of chasing a pointer per key
+    node->keys = (unsigned char*)node + tree->arena.slab_offset;
+    memset(node->keys, 0, tree->arena.slab_size - tree->arena.slab_offset); // NULL-initialize keys and pointers
+    void **pointers = (void**)(node->keys + tree->key_block_size);
+
+    if (is_leaf) {
+        node->node_type.leaf.data_pointers = pointers;
+        node->node_type.leaf.next = NULL;
+        node->node_type.leaf.prev = NULL;
+    } else {
+        node->node_type.internal.C = (BPlusTreeNode**)pointers;
+    }
+    return node;
+}
+
+// Frees the keys/data owned by a single node (not its children) and hands the slab back to the arena
+void releaseBPlusTreeNode(BPlusTreeNode *node) {
+    if (!node) return;
+    releaseNodeContents(node);
+    nodeArenaFree(&node->tree->arena, node);
+}
+
+// --- Node Arena ---
+void nodeArenaInit(NodeArena *arena, size_t block_size) {
+    arena->slab_offset = roundUpToCacheLine(sizeof(BPlusTreeNode));
+    arena->slab_size = arena->slab_offset + roundUpToCacheLine(block_size);
+    arena->chunks = NULL;
+    arena->free_list = NULL;
+    arena->next_capacity = NODE_ARENA_MIN_CHUNK;
+    arena->live_nodes = 0;
+}
+
+// Returns an uninitialized slab: from the free list if possible, else the newest chunk,
+// else a new chunk (one aligned_alloc per chunk instead of per node)
+BPlusTreeNode* nodeArenaAlloc(NodeArena *arena) {
+    BPlusTreeNode *node = arena->free_list;
+    if (node) {
+        arena->free_list = node->node_type.leaf.next;
+        arena->live_nodes++;
+        return node;
+    }
+    size_t header = roundUpToCacheLine(sizeof(NodeArenaChunk));
+    NodeArenaChunk *chunk = arena->chunks;
+    if (!chunk || chunk->used == chunk->capacity) {
+        chunk = aligned_alloc(CACHE_LINE_SIZE, header + (size_t)arena->next_capacity * arena->slab_size);
+        if (!chunk) return NULL;
+        chunk->next = arena->chunks;
+        chunk->used = 0;
+        chunk->capacity = arena->next_capacity;
+        arena->chunks = chunk;
+        if (arena->next_capacity < NODE_ARENA_MAX_CHUNK) arena->next_capacity *= 2;
+    }
+    node = (BPlusTreeNode*)((unsigned char*)chunk + header + (size_t)chunk->used * arena->slab_size);
+    chunk->used++;
+    arena->live_nodes++;
+    return node;
+}
+
+void nodeArenaFree(NodeArena *arena, BPlusTreeNode *node) {
+    node->n = -1; // Marks the slab as free for arena walks
+    node->node_type.leaf.next = arena->free_list;
+    arena->free_list = node;
+    arena->live_nodes--;
+}
+
+// Makes sure the next 'slabs' allocations are carved from a single chunk (one aligned_alloc instead
+// of a chain of doubling chunks). Unused slabs left in the previous chunk are simply not used.
+bool nodeArenaReserve(NodeArena *arena, int slabs) {
+    NodeArenaChunk *current = arena->chunks;
+    if (slabs <= 0 || (current && current->capacity - current->used >= slabs)) return true;
+    size_t header = roundUpToCacheLine(sizeof(NodeArenaChunk));
+    NodeArenaChunk *chunk = aligned_alloc(CACHE_LINE_SIZE, header + (size_t)slabs * arena->slab_size);
+    if (!chunk) return false;
+    chunk->next = arena->chunks;
+    chunk->used = 0;
+    chunk->capacity = slabs;
+    arena->chunks = chunk;
+    return true;
+}
+
+// Slabs the arena can hand out without allocating: the free list and the rest of the newest chunk
+size_t nodeArenaSpareSlabs(const NodeArena *arena) {
+    size_t carved = 0;
+    for (const NodeArenaChunk *chunk = arena->chunks; chunk; chunk = chunk->next) carved += chunk->used;
+    size_t unused = arena->chunks ? (size_t)(arena->chunks->capacity - arena->chunks->used) : 0;
+    return carved - arena->live_nodes + unused;
+}
+
+void nodeArenaRelease(NodeArena *arena) {
+    NodeArenaChunk *chunk = arena->chunks;
+    while (chunk) {
+        NodeArenaChunk *next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+    arena->chunks = NULL;
+    arena->free_list = NULL;
+    arena->live_nodes = 0;
+}
+
+size_t roundUpToCacheLine(size_t bytes) {
+    return (bytes + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE * CACHE_LINE_SIZE;
+}
+
+// Returns the key at slot i: the slot itself for inline keys, the pointer stored in it otherwise
+const void* nodeKeyAt(const BPlusTreeNode *node, int i) {
+    const unsigned char *slot = node->keys + (size_t)i * node->tree->key_stride;
+    return node->tree->inline_keys ? (const void*)slot : *(void* const*)slot;
+}
+
+// Stores key at slot i, taking ownership: inline trees copy the value and release the key
+void nodeKeyStore(BPlusTreeNode *node, int i, void *key) {
+    BPlusTree *tree = node->tree;
+    unsigned char *slot = node->keys + (size_t)i * tree->key_stride;
+    if (tree->inline_keys) {
+        memcpy(slot, key, tree->key_size);
+        if (tree->free_key) tree->free_key(key);
+    } else {
+        memcpy(slot, &key, sizeof(void*));
+    }
+}
+
+// Removes ownership of the key at slot i and returns it (inline trees return a heap copy)
+void* nodeKeyTake(BPlusTreeNode *node, int i) {
+    if (node->tree->inline_keys) return duplicateKey(node->tree, nodeKeyAt(node, i));
+    void *key = (void*)nodeKeyAt(node, i);
+    memset(node->keys + (size_t)i * node->tree->key_stride, 0, sizeof(void*));
+    return key;
+}
+
+// Moves count key slots from src starting at src_index to dst starting at dst_index (overlap-safe)
+void nodeKeysMove(BPlusTreeNode *dst, int dst_index, BPlusTreeNode *src, int src_index, int count) {
+    if (count <= 0) return;
+    size_t stride = dst->tree->key_stride;
+    memmove(dst->keys + (size_t)dst_index * stride, src->keys + (size_t)src_index * stride, (size_t)count * stride);
+}
+
+// Frees the key at slot i if it is a separately allocated key (no-op for inline keys)
+void nodeKeyRelease(BPlusTreeNode *node, int i) {
+    BPlusTree *tree = node->tree;
+    if (tree->inline_keys || !tree->free_key) return;
+    void *key = (void*)nodeKeyAt(node, i);
+    if (key) tree->free_key(key);
+}
+
+// Overwrites separator slot dst_index with a copy of the key at src slot src_index. Inline keys are
+// copied by value; otherwise the old separator is released and replaced by a duplicate.
+void nodeKeyCopy(BPlusTreeNode *dst, int dst_index, const BPlusTreeNode *src, int src_index) {
+    BPlusTree *tree = dst->tree;
+    if (tree->inline_keys) {
+        memcpy(dst->keys + (size_t)dst_index * tree->key_stride, nodeKeyAt(src, src_index), tree->key_size);
+        return;
+    }
+    void *copy = duplicateKey(tree, nodeKeyAt(src, src_index));
+    if (!copy) return; // Logged by duplicateKey; the old separator stays
+    nodeKeyRelease(dst, dst_index);
+    memcpy(dst->keys + (size_t)dst_index * tree->key_stride, &copy, sizeof(void*));
+}
+
+BPlusTree* createBPlusTree(int t, size_t key_size,   int (*compare)(const void*, const void*),
+                           void (*free_key)(void*),   void (*free_data)(void*)) {
+    if (t < 2) {
+       // fprintf(stderr, "Error: B+ Tree minimum degree t must be at least 2.\n");
+        logError("Error: B+ Tree minimum degree t must be at least 2.\n");
+        return NULL;
+    }
+    BPlusTree *tree = (BPlusTree*)malloc(sizeof(BPlusTree));
+    if (!tree) {
+     //   perror(" Failed to allocate B+ Tree structure");
+        logError(" Failed to allocate B+ Tree structure. Exiting.\n");
+        logFlush();
+       // exit(EXIT_FAILURE);
+    }
+
+    tree->t = t;
+    tree->compare = compare;
+    tree->free_key = free_key;
+    tree->free_data = free_data;
+    tree->key_size = key_size; // Store key size
+    tree->inline_keys = key_size > 0;
+    tree->key_stride = tree->inline_keys ? key_size : sizeof(void*);
+    tree->key_block_size = roundUpToCacheLine((size_t)(2 * t - 1) * tree->key_stride);
+    tree->node_search = NULL; // Compare-based until setBPlusTreeKeyKind picks a kernel
+    tree->node_search_name = "generic";
+    nodeArenaInit(&tree->arena, tree->key_block_size + (size_t)(2 * t) * sizeof(void*)); // Sized for the larger (internal) pointer array
+    tree->amount_index = NULL;
+    tree->amount_entries = 0;
+    tree->root = createBPlusTreeNode(tree, true); 
+    tree->first_leaf = tree->root; 
+
+    return tree;
+}
+
+// Binary search over a node's keys: returns the first index whose key is >= key
+// (or > key when `upper` is set), or node->n if there is none.
+// Shared by every search/insert path so each node costs O(log n) comparisons.
+// Trees with a specialized kernel (setBPlusTreeKeyKind) use it instead.
+int nodeLowerBound(const BPlusTreeNode *node, const void *key, bool upper) {
+    if (node->tree->node_search) return node->tree->node_search(node->keys, node->n, key, upper);
+    int (*compare)(const void*, const void*) = node->tree->compare;
+    int lo = 0, hi = node->n;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        int cmp = compare(nodeKeyAt(node, mid), key);
+        if (cmp < 0 || (upper && cmp == 0)) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+// --- Node Search Kernels ---
+// Specialized replacements for the compare-based binary search in nodeLowerBound, selected once per
+// tree by setBPlusTreeKeyKind. Each returns the number of keys < probe (or <= probe when `upper`),
+// which for sorted keys is the lower/upper bound index. The vector kernels compare a whole chunk of
+// keys at once and count hits with movemask/popcount; they may read past n up to the end of the
+// cache-line rounded key block, and lanes beyond n are masked out.
+
+int nodeSearchIntScalar(const unsigned char *keys, int n, const void *key, bool upper) {
+    const int *k = (const int*)keys;
+    int probe = *(const int*)key;
+    int lo = 0, hi = n;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (k[mid] < probe || (upper && k[mid] == probe)) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+int nodeSearchPlateScalar(const unsigned char *keys, int n, const void *key, bool upper) {
+    const PlateKey *k = (const PlateKey*)keys;
+    const PlateKey *probe = (const PlateKey*)key;
+    int lo = 0, hi = n;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        bool less = k[mid].hi < probe->hi || (k[mid].hi == probe->hi && (k[mid].lo < probe->lo || (upper && k[mid].lo == probe->lo)));
+        if (less) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+#if PARKING_X86_SIMD
+int nodeSearchIntSse2(const unsigned char *keys, int n, const void *key, bool upper) {
+    const int *k = (const int*)keys;
+    __m128i probe = _mm_set1_epi32(*(const int*)key);
+    int count = 0;
+    for (int i = 0; i < n; i += 4) {
+        __m128i v = _mm_load_si128((const __m128i*)(k + i));
+        // key < probe, or key <= probe as NOT(key > probe)
+        __m128i hit = upper ? _mm_andnot_si128(_mm_cmpgt_epi32(v, probe), _mm_set1_epi32(-1)) : _mm_cmpgt_epi32(probe, v);
+        int valid = (n - i >= 4) ? 0xF : (1 << (n - i)) - 1;
+        int mask = _mm_movemask_ps(_mm_castsi128_ps(hit)) & valid;
+        count += __builtin_popcount(mask);
+        if (mask != valid) break; // Keys are sorted: no hits past the first miss
+    }
+    return count;
+}
+
+__attribute__((target("avx2")))
+int nodeSearchIntAvx2(const unsigned char *keys, int n, const void *key, bool upper) {
+    const int *k = (const int*)keys;
+    __m256i probe = _mm256_set1_epi32(*(const int*)key);
+    int count = 0;
+    for (int i = 0; i < n; i += 8) {
+        __m256i v = _mm256_load_si256((const __m256i*)(k + i));
+        __m256i hit = upper ? _mm256_andnot_si256(_mm256_cmpgt_epi32(v, probe), _mm256_set1_epi32(-1)) : _mm256_cmpgt_epi32(probe, v);
+        int valid = (n - i >= 8) ? 0xFF : (1 << (n - i)) - 1;
+        int mask = _mm256_movemask_ps(_mm256_castsi256_ps(hit)) & valid;
+        count += __builtin_popcount(mask);
+        if (mask != valid) break;
+    }
+    return count;
+}
+
+// Plates are compared as unsigned (hi, lo) pairs. Comparing every key loses to a binary search
+// once nodes get wide, so a scalar binary search over the aligned four-key groups first finds the
+// group holding the bound (the first whose last key is not below the probe), and only that group
+// is compared at once: its two loads are de-interleaved into a hi vector and a lo vector (lane
+// order k0, k2, k1, k3) and the sign bit is flipped so the signed 64-bit compare orders them as
+// unsigned values.
+__attribute__((target("avx2")))
+int nodeSearchPlateAvx2(const unsigned char *keys, int n, const void *key, bool upper) {
+    static const int valid_lanes[4] = {0x0, 0x1, 0x5, 0x7}; // Lanes holding k0..k(rem-1)
+    const PlateKey *k = (const PlateKey*)keys;
+    const PlateKey *probe = (const PlateKey*)key;
+    int lo = 0, hi = (n + 3) / 4;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        const PlateKey *last = &k[4 * mid + 3 < n ? 4 * mid + 3 : n - 1];
+        bool less = last->hi < probe->hi || (last->hi == probe->hi && (last->lo < probe->lo || (upper && last->lo == probe->lo)));
+        if (less) lo = mid + 1;
+        else hi = mid;
+    }
+    int first = 4 * lo;
+    if (first >= n) return n;
+
+    const __m256i sign = _mm256_set1_epi64x(INT64_MIN);
+    const __m256i probe_hi = _mm256_set1_epi64x((long long)(probe->hi ^ (uint64_t)INT64_MIN));
+    const __m256i probe_lo = _mm256_set1_epi64x((long long)(probe->lo ^ (uint64_t)INT64_MIN));
+    const __m256i *group = (const __m256i*)(k + first);
+    __m256i a = _mm256_load_si256(group);     // hi0 lo0 | hi1 lo1
+    __m256i b = _mm256_load_si256(group + 1); // hi2 lo2 | hi3 lo3
+    __m256i vhi = _mm256_xor_si256(_mm256_unpacklo_epi64(a, b), sign);
+    __m256i vlo = _mm256_xor_si256(_mm256_unpackhi_epi64(a, b), sign);
+    __m256i lo_hit = upper ? _mm256_andnot_si256(_mm256_cmpgt_epi64(vlo, probe_lo), _mm256_set1_epi64x(-1))
+                           : _mm256_cmpgt_epi64(probe_lo, vlo);
+    __m256i hit = _mm256_or_si256(_mm256_cmpgt_epi64(probe_hi, vhi),
+                                  _mm256_and_si256(_mm256_cmpeq_epi64(probe_hi, vhi), lo_hit));
+    int valid = (n - first >= 4) ? 0xF : valid_lanes[n - first];
+    return first + __builtin_popcount(_mm256_movemask_pd(_mm256_castsi256_pd(hit)) & valid);
+}
+#endif
+
+// Picks the node search kernel for the tree's key layout and the CPU it runs on.
+// Setting PARKING_NO_SIMD in the environment forces the scalar kernels.
+void setBPlusTreeKeyKind(BPlusTree *tree, BPlusKeyKind kind) {
+    if (!tree) return;
+    bool simd_allowed = getenv("PARKING_NO_SIMD") == NULL;
+    tree->node_search = NULL;
+    tree->node_search_name = "generic";
+    if (kind == KEY_KIND_INT && tree->key_size == sizeof(int)) {
+        tree->node_search = nodeSearchIntScalar;
+        tree->node_search_name = "int scalar";
+#if PARKING_X86_SIMD
+        if (simd_allowed && __builtin_cpu_supports("avx2")) {
+            tree->node_search = nodeSearchIntAvx2;
+            tree->node_search_name = "int AVX2";
+        } else if (simd_allowed) {
+            tree->node_search = nodeSearchIntSse2; // SSE2 is part of the x86-64 baseline
+            tree->node_search_name = "int SSE2";
+        }
+#endif
+    } else if (kind == KEY_KIND_PLATE && tree->key_size == sizeof(PlateKey)) {
+        tree->node_search = nodeSearchPlateScalar;
+        tree->node_search_name = "plate scalar";
+#if PARKING_X86_SIMD
+        if (simd_allowed && __builtin_cpu_supports("avx2")) { // 64-bit lane compares need AVX2
+            tree->node_search = nodeSearchPlateAvx2;
+            tree->node_search_name = "plate AVX2";
+        }
+#endif
+    }
+    (void)simd_allowed;
+}
+
+// Finds the leaf node where the key *should* exist or be inserted
+BPlusTreeNode* findLeaf(BPlusTreeNode *node, const void *key) {
+    if (!node || !key) return NULL; // NULL check for key
+    BPlusTree *tree = node->tree;
+    if (!tree) return NULL; 
+    BPlusTreeNode *current_node = node; // Use a temporary variable
+    while (current_node && !current_node->is_leaf) {
+        // Find the first key greater than the search key
+        int i = nodeLowerBound(current_node, key, true);
+        // Follow the child pointer C[i]
+        if (!current_node->node_type.internal.C) {
+          //   fprintf(stderr, "Error: Corrupted internal node detected during findLeaf.\n");
+             logError("Error: Corrupted internal node detected during findLeaf.\n");
+             return NULL; 
+        }
+        current_node = current_node->node_type.internal.C[i];
+    }
+    // Return NULL if traversal failed
+    return current_node && current_node->is_leaf ? current_node : NULL;
+}
+
+
+// Searches the B+ Tree for a key and returns the associated data pointer.
+// The key is borrowed for the duration of the call (a stack PlateKey or int is fine): nothing is
+// copied or kept, so lookups never allocate.
+void* searchBPlusTree(BPlusTree *tree, const void *key) {
+    if (!tree || !tree->root || !key) 
+       return NULL;
+    BPlusTreeNode *leaf = findLeaf(tree->root, key);
+    if (!leaf || !leaf->node_type.leaf.data_pointers) return NULL;
+
+    int i = nodeLowerBound(leaf, key, false);
+    if (i < leaf->n && tree->compare(key, nodeKeyAt(leaf, i)) == 0) {
+        return leaf->node_type.leaf.data_pointers[i];
+    }
+    return NULL; 
+}
+
+// --- Leaf Cursor ---
+// Walks the leaf chain through leaf.next/leaf.prev, one entry at a time, so a scan in key order
+// costs one descent plus O(1) per entry and never collects into a list. Empty leaves (only an
+// empty root today) are stepped over.
+
+bool cursorFirst(BPlusCursor *cursor, BPlusTree *tree) {
+    cursor->tree = tree;
+    cursor->leaf = tree ? tree->first_leaf : NULL;
+    cursor->pos = 0;
+    while (cursor->leaf && cursor->leaf->n == 0) cursor->leaf = cursor->leaf->node_type.leaf.next;
+    return cursor->leaf != NULL;
+}
+
+// There is no last_leaf pointer, so this follows the rightmost children down from the root
+bool cursorLast(BPlusCursor *cursor, BPlusTree *tree) {
+    BPlusTreeNode *node = tree ? tree->root : NULL;
+    while (node && !node->is_leaf) node = node->node_type.internal.C[node->n];
+    while (node && node->n == 0) node = node->node_type.leaf.prev;
+    cursor->tree = tree;
+    cursor->leaf = node;
+    cursor->pos = node ? node->n - 1 : 0;
+    return node != NULL;
+}
+
+bool cursorSeek(BPlusCursor *cursor, BPlusTree *tree, const void *key) {
+    cursor->tree = tree;
+    cursor->leaf = (tree && key) ? findLeaf(tree->root, key) : NULL;
+    cursor->pos = cursor->leaf ? nodeLowerBound(cursor->leaf, key, false) : 0;
+    while (cursor->leaf && cursor->pos >= cursor->leaf->n) { // Past this leaf: the answer starts the next one
+        cursor->leaf = cursor->leaf->node_type.leaf.next;
+        cursor->pos = 0;
+    }
+    return cursor->leaf != NULL;
+}
+
+bool cursorNext(BPlusCursor *cursor) {
+    if (!cursor->leaf) return false;
+    if (++cursor->pos < cursor->leaf->n) return true;
+    cursor->pos = 0;
+    do {
+        cursor->leaf = cursor->leaf->node_type.leaf.next;
+    } while (cursor->leaf && cursor->leaf->n == 0);
+    return cursor->leaf != NULL;
+}
+
+bool cursorPrev(BPlusCursor *cursor) {
+    if (!cursor->leaf) return false;
+    if (--cursor->pos >= 0) return true;
+    do {
+        cursor->leaf = cursor->leaf->node_type.leaf.prev;
+    } while (cursor->leaf && cursor->leaf->n == 0);
+    cursor->pos = cursor->leaf ? cursor->leaf->n - 1 : 0;
+    return cursor->leaf != NULL;
+}
+
+bool cursorValid(const BPlusCursor *cursor) {
+    return cursor->leaf && cursor->pos >= 0 && cursor->pos < cursor->leaf->n;
+}
+
+const void* cursorKey(const BPlusCursor *cursor) {
+    return cursorValid(cursor) ? nodeKeyAt(cursor->leaf, cursor->pos) : NULL;
+}
+
+void* cursorData(const BPlusCursor *cursor) {
+    return cursorValid(cursor) ? cursor->leaf->node_type.leaf.data_pointers[cursor->pos] : NULL;
+}
+
+// Visits every entry with lo <= key <= hi in key order. It descends once (findLeaf) to lo instead
+// of walking the leaves from first_leaf, and stops at the first key past hi or when visit returns
+// false. Returns the number of entries visited.
+int rangeScan(BPlusTree *tree, const void *lo, const void *hi, BPlusVisitor visit, void *ctx) {
+    if (!tree || !visit) return 0;
+    BPlusCursor cursor;
+    if (lo) cursorSeek(&cursor, tree, lo);
+    else cursorFirst(&cursor, tree);
+    int visited = 0;
+    for (; cursorValid(&cursor); cursorNext(&cursor)) {
+        const void *key = cursorKey(&cursor);
+        if (hi && tree->compare(key, hi) > 0) break;
+        visited++;
+        if (!visit(key, cursorData(&cursor), ctx)) break;
+    }
+    return visited;
+}
+
+// Inserts a key-data pair into the leaf node, maintaining sorted order
+void insertIntoLeaf(BPlusTreeNode *leaf, void *key, void *data_ptr) {
+    if (!leaf || !leaf->is_leaf || !key || !data_ptr) return; 
+    BPlusTree *tree = leaf->tree;
+    if (!tree) return; // Node must belong to a tree
+    if (!leaf->keys || !leaf->node_type.leaf.data_pointers) {
+       // fprintf(stderr, "Error: Corrupted leaf node (missing arrays) in insertIntoLeaf.\n");
+        logError("Error: Corrupted leaf node (missing arrays) in insertIntoLeaf.\n");
+        return;
+    }
+    if (leaf->n >= 2 * tree->t - 1) {
+       //      fprintf(stderr, "Error: Index out of bounds during shift in insertIntoLeaf.\n");
+         logError("Error: Index out of bounds for insertion in insertIntoLeaf.\n");
+         return; // Avoid buffer overflow
+    }
+
+    // Find position to insert (maintaining sorted order) and shift the tail right by one
+    int pos = nodeLowerBound(leaf, key, false);
+    nodeKeysMove(leaf, pos + 1, leaf, pos, leaf->n - pos);
+    memmove(leaf->node_type.leaf.data_pointers + pos + 1, leaf->node_type.leaf.data_pointers + pos,
+            (leaf->n - pos) * sizeof(void*));
+    nodeKeyStore(leaf, pos, key);
+    leaf->node_type.leaf.data_pointers[pos] = data_ptr;
+    leaf->n++;
+}
+
+// Inserts a key and a new right child into an internal node
+void insertIntoInternal(BPlusTreeNode *node, void *key, BPlusTreeNode *right_child) {
+     if (!node || node->is_leaf || !key || !right_child) return; // Basic validation
+     BPlusTree *tree = node->tree;
+     if (!tree) return;
+
+     // Check if arrays are valid
+     if (!node->keys || !node->node_type.internal.C) {
+       // fprintf(stderr, "Error: Corrupted internal node (missing arrays) in insertIntoInternal.\n");
+        logError("Error: Corrupted internal node (missing arrays) in insertIntoInternal.\n");
+        return;
+     }
+     if (node->n >= 2 * tree->t - 1) {
+  //       fprintf(stderr, "Error: Index out of bounds for insertion in insertIntoInternal.\n");
+         logError("Error: Index out of bounds for insertion in insertIntoInternal.\n");
+         return; // Avoid buffer overflow
+     }
+
+     // Key goes after every key <= it; the new right child sits just after it
+     int pos = nodeLowerBound(node, key, true);
+     nodeKeysMove(node, pos + 1, node, pos, node->n - pos);
+     memmove(node->node_type.internal.C + pos + 2, node->node_type.internal.C + pos + 1,
+             (node->n - pos) * sizeof(BPlusTreeNode*));
+     nodeKeyStore(node, pos, key);
+     node->node_type.internal.C[pos + 1] = right_child;
+     node->n++;
+}
+
+
+// Splits a full leaf node into two, updates linked list, and returns the middle key and new node
+void splitLeafNode(BPlusTreeNode *leaf, void **key_to_push_up, BPlusTreeNode **new_leaf_node) {
+    if (!leaf || !leaf->is_leaf || !key_to_push_up || !new_leaf_node) return;
+    BPlusTree *tree = leaf->tree;
+    if (!tree) return;
+    int t = tree->t;
+
+    *new_leaf_node = createBPlusTreeNode(tree, true);
+    if (!*new_leaf_node) { 
+        *key_to_push_up = NULL;
+        return;
+    }
+    BPlusTreeNode *new_leaf = *new_leaf_node;
+
+    int split_point = t; 
+    // The key to copy up is the *first* key of the new node
+    *key_to_push_up = duplicateKey(tree, nodeKeyAt(leaf, split_point));
+    if (!*key_to_push_up) {
+      //  perror(" Failed to allocate key for push up");
+        logError(" Failed to allocate key for push up during leaf split. Split aborted.\n");
+        releaseBPlusTreeNode(new_leaf); // Still empty: just hands the slab back to the arena
+        *new_leaf_node = NULL;
+        return; // The caller sees the NULL node and drops the insert; 'leaf' is untouched
+    }
+
+    // Move the second half of keys and data pointers to the new leaf
+    new_leaf->n = 0;
+    for (int i = split_point; i < 2 * t - 1; i++) {
+        if (new_leaf->n >= 2 * t - 1) {
+           //  fprintf(stderr, "Error: Exceeded new leaf capacity during split.\n");
+             logError("Error: Exceeded new leaf capacity during split.\n");
+             // Potential memory leak of *key_to_push_up
+             if (tree->free_key) tree->free_key(*key_to_push_up);
+             *key_to_push_up = NULL;
+             // Tree might be inconsistent
+             return;
+        }
+        nodeKeysMove(new_leaf, new_leaf->n, leaf, i, 1);
+        new_leaf->node_type.leaf.data_pointers[new_leaf->n] = leaf->node_type.leaf.data_pointers[i];
+        leaf->node_type.leaf.data_pointers[i] = NULL; // Null out moved pointers in old leaf
+        new_leaf->n++;
+    }
+    // Update original leaf's key count
+    leaf->n = split_point;
+
+    // Update linked list pointers
+    new_leaf->node_type.leaf.next = leaf->node_type.leaf.next;
+    if (new_leaf->node_type.leaf.next != NULL) {
+        new_leaf->node_type.leaf.next->node_type.leaf.prev = new_leaf;
+    }
+    leaf->node_type.leaf.next = new_leaf;
+    new_leaf->node_type.leaf.prev = leaf;
+}
+
+// Splits a full internal node into two, pushes middle key up, returns key and new node
+void splitInternalNode(BPlusTreeNode *node, void **key_to_push_up, BPlusTreeNode **new_internal_node) {
+    if (!node || node->is_leaf || !key_to_push_up || !new_internal_node) return;
+    BPlusTree *tree = node->tree;
+     if (!tree) return;
+    int t = tree->t;
+    *new_internal_node = createBPlusTreeNode(tree, false);
+     if (!*new_internal_node) { 
+        *key_to_push_up = NULL;
+        return;
+    }
+    BPlusTreeNode *new_node = *new_internal_node;
+    // Middle key index (key at t-1 is pushed up)
+    int split_key_index = t - 1;
+
+    // Key to push up is the middle key
+    *key_to_push_up = nodeKeyTake(node, split_key_index); // Pass key up, removed from original node
+    if (!*key_to_push_up) { // Inline keys are handed up as a copy, which can fail to allocate
+        releaseBPlusTreeNode(new_node);
+        *new_internal_node = NULL;
+        return;
+    }
+
+    // Move keys from index t onwards to the new node
+    new_node->n = 0;
+    for (int i = split_key_index + 1; i < 2 * t - 1; i++) {
+         if (new_node->n >= 2 * t - 1) {
+           //  fprintf(stderr, "Error: Exceeded new internal node key capacity during split.\n");
+             logError("Error: Exceeded new internal node key capacity during split.\n");
+             // Key *key_to_push_up might leak if not handled by caller
+             return;
+         }
+        nodeKeysMove(new_node, new_node->n++, node, i, 1);
+    }
+
+    // Move child pointers from index t onwards to the new node
+    for (int i = t; i < 2 * t; i++) {
+         if (i - t >= 2 * t) {
+           //  fprintf(stderr, "Error: Exceeded new internal node child capacity during split.\n");
+             logError("Error: Exceeded new internal node child capacity during split.\n");
+             return;
+         }
+        new_node->node_type.internal.C[i - t] = node->node_type.internal.C[i];
+        node->node_type.internal.C[i] = NULL;
+    }
+    // Update original node's key count
+    node->n = split_key_index; // t-1 keys remain
+}
+
+// Main insertion function
+void insertBPlusTree(BPlusTree *tree, void *key, void *data_ptr) {
+    if (!tree || !key || !data_ptr) {
+       // fprintf(stderr, "Error: Invalid arguments for insertBPlusTree.\n");
+        logError("Error: Invalid arguments for insertBPlusTree (key=%p, data=%p).\n", key, data_ptr);
+        return;
+    }
+    // Handle empty tree case
+    if (tree->root == NULL) { 
+         logError("Error: Tree root was NULL during insert. Recreating root.\n");
+         tree->root = createBPlusTreeNode(tree, true);
+         tree->first_leaf = tree->root;
+    }
+    if (tree->root->n == 0 && tree->root->is_leaf) {
+        nodeKeyStore(tree->root, 0, key);
+        tree->root->node_type.leaf.data_pointers[0] = data_ptr;
+        tree->root->n = 1;
+        return;
+    }
+
+    // Find the appropriate leaf node
+    BPlusTreeNode *leaf = findLeaf(tree->root, key);
+    if (!leaf) {
+     //   fprintf(stderr, "Error: Could not find leaf node for insertion.\n");
+        logError("Error: Could not find leaf node for insertion.\n");
+         // Free key/data as insertion failed
+         if (key && tree->free_key) tree->free_key(key);
+         if (data_ptr && tree->free_data) tree->free_data(data_ptr);
+        return;
+    }
+
+    // Check for duplicates *before* insertion/split
+    int pos = nodeLowerBound(leaf, key, false);
+    if (pos < leaf->n && tree->compare(key, nodeKeyAt(leaf, pos)) == 0) {
+     //   fprintf(stderr, "Error: Duplicate key insertion attempted.\n");
+        logError("Error: Duplicate key insertion attempted.\n");
+        // Free the new key/data as they won't be inserted
+        if (key && tree->free_key) tree->free_key(key);
+        if (data_ptr && tree->free_data) tree->free_data(data_ptr);
+        return;
+    }
+    // If leaf has space
+    if (leaf->n < 2 * tree->t - 1) {
+        insertIntoLeaf(leaf, key, data_ptr);
+    } else { // Leaf is full, need to split
+        void *key_to_push_up = NULL; // This will be allocated by splitLeafNode
+        BPlusTreeNode *new_leaf = NULL;
+        splitLeafNode(leaf, &key_to_push_up, &new_leaf);
+
+        if (!new_leaf || !key_to_push_up) {
+           //  fprintf(stderr, "Error: Leaf split failed.\n");
+             logError("Error: Leaf split failed. Insertion aborted.\n");
+             if (key_to_push_up && tree->free_key) tree->free_key(key_to_push_up);
+             if (key && tree->free_key) tree->free_key(key);
+             if (data_ptr && tree->free_data) tree->free_data(data_ptr);
+             return;
+        }
+        // Both halves now have room: place the new entry on its side of the separator
+        if (tree->compare(key, key_to_push_up) < 0) insertIntoLeaf(leaf, key, data_ptr);
+        else insertIntoLeaf(new_leaf, key, data_ptr);
+
+        // Insert the middle key (copy created in splitLeafNode) into the parent
+        insertIntoParent(leaf, key_to_push_up, new_leaf);
+    }
+}
+
+// Recursive helper to insert into parent, handling splits up the tree
+void insertIntoParent(BPlusTreeNode *node, void *key, BPlusTreeNode *right_child) {
+    if (!node || !key || !right_child) { 
+     //    fprintf(stderr, "Error: Invalid arguments for insertIntoParent.\n");
+         logError("Error: Invalid arguments for insertIntoParent.\n");
+         if (key && node && node->tree && node->tree->free_key) node->tree->free_key(key);
+         return;
+    }
+    BPlusTree *tree = node->tree;
+    if (!tree) {
+     //    fprintf(stderr, "Error: Node has no tree reference in insertIntoParent.\n");
+         logError("Error: Node has no tree reference in insertIntoParent.\n");
+         return;
+    }
+    if (tree->root == node) {
+        BPlusTreeNode *new_root = createBPlusTreeNode(tree, false);
+        nodeKeyStore(new_root, 0, key);
+        new_root->node_type.internal.C[0] = node;
+        new_root->node_type.internal.C[1] = right_child;
+        new_root->n = 1;
+        tree->root = new_root;
+        // Key is now owned by the new root, do not free here.
+        return;
+    }
+    //  find parent node: descend by key until a node whose child is `node`
+    BPlusTreeNode *parent = NULL;
+    BPlusTreeNode *current = tree->root;
+    while (current && !current->is_leaf) {
+        int i = nodeLowerBound(current, key, true);
+        if (current->node_type.internal.C[i] == node || (i > 0 && current->node_type.internal.C[i - 1] == node)) {
+            parent = current;
+            break;
+        }
+        current = current->node_type.internal.C[i]; // Go down
+    }
+
+    if (!parent) {
+      //   fprintf(stderr, "Critical Error: Could not find parent during insertion split propagation for key.\n");
+         logError(" Error: Could not find parent during insertion split propagation. Key may be lost.\n");
+         if (key && tree->free_key) tree->free_key(key);
+         return;
+    }
+    // If parent has space
+    if (parent->n < 2 * tree->t - 1) {
+        insertIntoInternal(parent, key, right_child);
+    } else { // Parent is full, split parent
+        void *key_to_push_further_up = NULL; // Pointer from parent node
+        BPlusTreeNode *new_internal_node = NULL;
+        splitInternalNode(parent, &key_to_push_further_up, &new_internal_node);
+
+         if (!new_internal_node || !key_to_push_further_up) {
+         //    fprintf(stderr, "Error: Internal node split failed.\n");
+             logError("Error: Internal node split failed. Insertion incomplete.\n");
+             return;
+         }
+        // Both halves now have room: the new separator goes on its side of the pushed-up key
+        if (tree->compare(key, key_to_push_further_up) < 0) insertIntoInternal(parent, key, right_child);
+        else insertIntoInternal(new_internal_node, key, right_child);
+
+        // Recursively insert the middle key into the parent's parent
+        insertIntoParent(parent, key_to_push_further_up, new_internal_node);
+    }
+}
+
+
+// Allocates a standalone copy of a key (used for separator keys in internal nodes)
+void* duplicateKey(BPlusTree *tree, const void *key) {
+    if (!tree || !key) return NULL;
+    // key_size 0 marks variable-length string keys (vehicle numbers)
+    size_t key_alloc_size = (tree->key_size == 0) ? (strlen((const char*)key) + 1) : tree->key_size;
+    void *copy = malloc(key_alloc_size);
+    if (!copy) {
+        logError(" Failed to allocate separator key copy.\n");
+        return NULL;
+    }
+    memcpy(copy, key, key_alloc_size);
+    return copy;
+}
+
+// Removes key from the tree; false if it is absent. The key is only borrowed and must not point
+// into the tree. The entry's key is released and its data is handed to *data_out, or released with
+// tree->free_data when data_out is NULL.
+// It serves every key type, including the trees searched through bplustree_template.h.
+// A node left with fewer than t-1 keys borrows from a sibling that can spare one, else merges into
+// its left neighbour (or takes in its right one). The emptied node is unlinked from the leaf list and its
+// slab returned to the arena, and the parent loses one separator, which may underflow it in turn.
+// A root left with no keys and one child is replaced by that child.
+bool deleteBPlusTree(BPlusTree *tree, const void *key, void **data_out) {
+    if (data_out) *data_out = NULL;
+    if (!tree || !tree->root || !key) return false;
+    BPlusTreeNode *path[BPT_MAX_HEIGHT];
+    int slots[BPT_MAX_HEIGHT]; // Child index taken at each internal node on the path
+    int depth = 0;
+    BPlusTreeNode *node = tree->root;
+    while (!node->is_leaf) {
+        path[depth] = node;
+        slots[depth] = nodeLowerBound(node, key, true);
+        node = node->node_type.internal.C[slots[depth]];
+        depth++;
+    }
+    int pos = nodeLowerBound(node, key, false);
+    if (pos >= node->n || tree->compare(key, nodeKeyAt(node, pos)) != 0) return false;
+    void **data = node->node_type.leaf.data_pointers;
+    void *removed = data[pos];
+    nodeKeyRelease(node, pos);
+    nodeKeysMove(node, pos, node, pos + 1, node->n - pos - 1);
+    memmove(data + pos, data + pos + 1, (node->n - pos - 1) * sizeof(void*));
+    node->n--;
+    data[node->n] = NULL;
+
+    const int min_keys = tree->t - 1;
+    while (depth > 0 && node->n < min_keys) {
+        BPlusTreeNode *parent = path[--depth];
+        int slot = slots[depth];
+        BPlusTreeNode **siblings = parent->node_type.internal.C;
+        BPlusTreeNode *left = slot > 0 ? siblings[slot - 1] : NULL;
+        BPlusTreeNode *right = slot < parent->n ? siblings[slot + 1] : NULL;
+        void **ptrs = node->is_leaf ? node->node_type.leaf.data_pointers : (void**)node->node_type.internal.C;
+        int extra = node->is_leaf ? 0 : 1; // Internal nodes hold one more pointer than keys
+
+        if (left && left->n > min_keys) {
+            // Borrow the left sibling's last entry; internal nodes rotate it through the parent
+            void **lptrs = left->is_leaf ? left->node_type.leaf.data_pointers : (void**)left->node_type.internal.C;
+            nodeKeysMove(node, 1, node, 0, node->n);
+            memmove(ptrs + 1, ptrs, (node->n + extra) * sizeof(void*));
+            if (node->is_leaf) {
+                nodeKeysMove(node, 0, left, left->n - 1, 1);
+                nodeKeyCopy(parent, slot - 1, node, 0);
+            } else {
+                nodeKeysMove(node, 0, parent, slot - 1, 1);
+                nodeKeysMove(parent, slot - 1, left, left->n - 1, 1);
+            }
+            ptrs[0] = lptrs[left->n - 1 + extra];
+            lptrs[left->n - 1 + extra] = NULL;
+            left->n--;
+            node->n++;
+            break;
+        }
+        if (right && right->n > min_keys) {
+            // Borrow the right sibling's first entry
+            void **rptrs = right->is_leaf ? right->node_type.leaf.data_pointers : (void**)right->node_type.internal.C;
+            if (node->is_leaf) {
+                nodeKeysMove(node, node->n, right, 0, 1);
+            } else {
+                nodeKeysMove(node, node->n, parent, slot, 1);
+                nodeKeysMove(parent, slot, right, 0, 1);
+            }
+            ptrs[node->n + extra] = rptrs[0];
+            nodeKeysMove(right, 0, right, 1, right->n - 1);
+            memmove(rptrs, rptrs + 1, (right->n - 1 + extra) * sizeof(void*));
+            rptrs[right->n - 1 + extra] = NULL;
+            right->n--;
+            node->n++;
+            if (node->is_leaf) nodeKeyCopy(parent, slot, right, 0);
+            break;
+        }
+
+        // Merge: 'from' (the right node of the pair) is appended to 'into' and freed
+        BPlusTreeNode *into = left ? left : node, *from = left ? node : right;
+        int sep = left ? slot - 1 : slot; // Parent key between the two
+        if (into->is_leaf) {
+            nodeKeysMove(into, into->n, from, 0, from->n);
+            memcpy(into->node_type.leaf.data_pointers + into->n, from->node_type.leaf.data_pointers, from->n * sizeof(void*));
+            into->n += from->n;
+            into->node_type.leaf.next = from->node_type.leaf.next;
+            if (from->node_type.leaf.next) from->node_type.leaf.next->node_type.leaf.prev = into;
+            nodeKeyRelease(parent, sep); // Leaf separators are copies; this one separates nothing now
+        } else {
+            nodeKeysMove(into, into->n, parent, sep, 1); // The separator comes down between the halves
+            nodeKeysMove(into, into->n + 1, from, 0, from->n);
+            memcpy(into->node_type.internal.C + into->n + 1, from->node_type.internal.C, (from->n + 1) * sizeof(BPlusTreeNode*));
+            into->n += from->n + 1;
+        }
+        nodeArenaFree(&tree->arena, from); // Its keys and entries now belong to 'into'
+        nodeKeysMove(parent, sep, parent, sep + 1, parent->n - sep - 1);
+        memmove(siblings + sep + 1, siblings + sep + 2, (parent->n - sep - 1) * sizeof(BPlusTreeNode*));
+        parent->n--;
+        siblings[parent->n + 1] = NULL;
+        node = parent;
+    }
+
+    if (!tree->root->is_leaf && tree->root->n == 0) {
+        BPlusTreeNode *old_root = tree->root;
+        tree->root = old_root->node_type.internal.C[0];
+        nodeArenaFree(&tree->arena, old_root);
+    }
+    if (data_out) *data_out = removed;
+    else if (removed && tree->free_data) tree->free_data(removed);
+    return true;
+}
+
+// Number of entries per bulk-loaded node for the given fill factor, clamped to [min_entries, max_entries]
+int bulkLoadNodeCapacity(int max_entries, int min_entries, double fill_factor) {
+    int capacity = (int)(fill_factor * max_entries + 0.5);
+    if (capacity > max_entries) capacity = max_entries;
+    if (capacity < min_entries) capacity = min_entries;
+    return capacity;
+}
+
+// Number of nodes a bulk-loaded level spreads 'entries' over: enough for 'capacity' each, but never so
+// many that an even split leaves a node below min_entries (a single node, the root, may hold fewer)
+int bulkLoadNodeCount(int entries, int capacity, int min_entries) {
+    int nodes = (entries + capacity - 1) / capacity;
+    if (nodes > 1 && entries / nodes < min_entries) nodes = entries / min_entries > 0 ? entries / min_entries : 1;
+    return nodes;
+}
+
+// Frees the subtrees bulkLoadBPlusTree built before it failed, with the separator copies made for
+// them. Leaf keys and data are left alone: after a failed load they still belong to the caller.
+void bulkLoadDiscard(BPlusTreeNode **nodes, int count) {
+    for (int i = 0; i < count; i++) {
+        BPlusTreeNode *node = nodes[i];
+        if (!node->is_leaf) {
+            for (int j = 0; j < node->n; j++) nodeKeyRelease(node, j);
+            bulkLoadDiscard(node->node_type.internal.C, node->n + 1);
+        }
+        nodeArenaFree(&node->tree->arena, node);
+    }
+}
+
+// Upper bound on the nodes a tree of degree t can hold with 'count' keys: every non-root leaf holds
+// at least t-1 keys and every non-root internal node at least t children
+int bplusTreeMaxNodes(int t, int count) {
+    int level = count / (t - 1) + 1, total = level;
+    while (level > 1) {
+        level = level / t + 1;
+        total += level;
+    }
+    return total;
+}
+
+// Builds an empty tree bottom-up from keys sorted in ascending order (no duplicates).
+// Leaves are packed to fill_factor of their capacity and linked left to right, then each
+// internal level is built over the one below until a single root remains.
+// The tree takes ownership of the data exactly as with insertBPlusTree. Inline trees copy the key
+// values and leave the keys with the caller; other trees take the keys too. On false the tree is
+// still empty and the keys and data still belong to the caller.
+bool bulkLoadBPlusTree(BPlusTree *tree, void **keys, void **data_ptrs, int count, double fill_factor) {
+    if (!tree || count < 0 || (count > 0 && (!keys || !data_ptrs))) {
+        logError("Error: Invalid arguments for bulkLoadBPlusTree.\n");
+        return false;
+    }
+    if (tree->root && (!tree->root->is_leaf || tree->root->n > 0)) {
+        logError("Error: bulkLoadBPlusTree requires an empty tree.\n");
+        return false;
+    }
+    for (int i = 1; i < count; i++) {
+        if (tree->compare(keys[i - 1], keys[i]) >= 0) {
+            logError("Error: bulkLoadBPlusTree input is not strictly ascending at index %d.\n", i);
+            return false;
+        }
+    }
+    if (count == 0) return true;
+    if (fill_factor <= 0.0 || fill_factor > 1.0) fill_factor = 1.0;
+
+    int t = tree->t;
+    int leaf_capacity = bulkLoadNodeCapacity(2 * t - 1, t - 1, fill_factor);
+    // At least 3 children per internal node so an even split never leaves a node with a single child
+    int fanout = bulkLoadNodeCapacity(2 * t, t > 3 ? t : 3, fill_factor);
+
+    // Every non-root node keeps the minimum occupancy the delete path relies on: t-1 keys per leaf
+    // and t children per internal node
+    int level_count = bulkLoadNodeCount(count, leaf_capacity, t - 1);
+    BPlusTreeNode **level = calloc(level_count, sizeof(BPlusTreeNode*));
+    void **level_min = calloc(level_count, sizeof(void*)); // Smallest key below each node of the level
+    if (!level || !level_min) {
+        logError(" Failed to allocate level arrays for bulk load.\n");
+        free(level); free(level_min);
+        return false;
+    }
+    // Every node is reserved before the first key is taken, so past this point only a separator
+    // copy can fail
+    int node_total = 0;
+    for (int nodes = level_count; ; nodes = bulkLoadNodeCount(nodes, fanout, t)) {
+        node_total += nodes;
+        if (nodes == 1) break;
+    }
+    if (!nodeArenaReserve(&tree->arena, node_total)) {
+        logError(" Failed to reserve %d nodes for bulk load.\n", node_total);
+        free(level); free(level_min);
+        return false;
+    }
+
+    // Leaf level: spread keys evenly so the last leaf is not left nearly empty
+    int base = count / level_count, extra = count % level_count, pos = 0;
+    BPlusTreeNode *prev_leaf = NULL;
+    for (int i = 0; i < level_count; i++) {
+        int take = base + (i < extra ? 1 : 0);
+        BPlusTreeNode *leaf = createBPlusTreeNode(tree, true); // Reserved above, cannot fail
+        for (int j = 0; j < take; j++) {
+            if (tree->inline_keys) memcpy(leaf->keys + (size_t)j * tree->key_stride, keys[pos + j], tree->key_size);
+            else nodeKeyStore(leaf, j, keys[pos + j]);
+        }
+        memcpy(leaf->node_type.leaf.data_pointers, data_ptrs + pos, take * sizeof(void*));
+        leaf->n = take;
+        leaf->node_type.leaf.prev = prev_leaf;
+        if (prev_leaf) prev_leaf->node_type.leaf.next = leaf;
+        prev_leaf = leaf;
+        level[i] = leaf;
+        level_min[i] = (void*)nodeKeyAt(leaf, 0);
+        pos += take;
+    }
+
+    // Internal levels: child j > 0 is separated by the smallest key of its subtree. If a separator
+    // cannot be copied, the parents built so far and the children not yet taken are discarded.
+    BPlusTreeNode *first_leaf = level[0];
+    while (level_count > 1) {
+        int parent_count = bulkLoadNodeCount(level_count, fanout, t);
+        base = level_count / parent_count;
+        extra = level_count % parent_count;
+        pos = 0;
+        for (int i = 0; i < parent_count; i++) {
+            int take = base + (i < extra ? 1 : 0);
+            BPlusTreeNode *node = createBPlusTreeNode(tree, false); // Reserved above
+            node->node_type.internal.C[0] = level[pos];
+            for (int j = 1; j < take; j++) {
+                if (tree->inline_keys) { // Copy the value; a heap duplicate would leak without free_key
+                    memcpy(node->keys + (size_t)(j - 1) * tree->key_stride, level_min[pos + j], tree->key_size);
+                } else {
+                    void *separator = duplicateKey(tree, level_min[pos + j]);
+                    if (!separator) {
+                        node->n = j - 1; // Owns its first j children and their separators
+                        bulkLoadDiscard(level, i);
+                        bulkLoadDiscard(&node, 1);
+                        bulkLoadDiscard(level + pos + j, level_count - pos - j);
+                        free(level); free(level_min);
+                        logError(" Failed to allocate a separator key for bulk load.\n");
+                        return false;
+                    }
+                    nodeKeyStore(node, j - 1, separator);
+                }
+                node->node_type.internal.C[j] = level[pos + j];
+            }
+            node->n = take - 1;
+            level[i] = node; // Safe to overwrite in place, i <= pos
+            level_min[i] = level_min[pos];
+            pos += take;
+        }
+        level_count = parent_count;
+    }
+    releaseBPlusTreeNode(tree->root); // Discard the empty root leaf
+    tree->root = level[0];
+    tree->first_leaf = first_leaf;
+
+    free(level);
+    free(level_min);
+    return true;
+}
+
+// --- Parking System Logic Implementations ---
+void updateMembership(Vehicle *v) {
+    if (!v) return;
+    MembershipType old_membership = v->membership;
+    if (v->total_parking_hours >= 200.0) {
+        v->membership = GOLD;
+    } else if (v->total_parking_hours >= 100.0) {
+        v->membership = PREMIUM;
+    } else {
+        v->membership = NO_MEMBERSHIP;
+    }
+}
+
+// Orders staged input rows by plate, then by line number so repeated plates replay in file order
+int compare_initial_records(const void *a, const void *b) {
+    const InitialRecord *r1 = *(const InitialRecord* const*)a;
+    const InitialRecord *r2 = *(const InitialRecord* const*)b;
+    int cmp = strcmp(r1->vehicle_number, r2->vehicle_number);
+    if (cmp != 0) return cmp;
+    return (r1->line_num > r2->line_num) - (r1->line_num < r2->line_num);
+}
+
+// --- Mapped Input Parsing ---
+
+// Maps path read-only. Falls back to reading the file into memory when it cannot be mapped.
+bool mapInputFile(const char *path, MappedFile *file) {
+    memset(file, 0, sizeof(*file));
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode)) {
+        if (st.st_size == 0) { // Nothing to map
+            close(fd);
+            return true;
+        }
+        void *addr = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr != MAP_FAILED) {
+            madvise(addr, (size_t)st.st_size, MADV_SEQUENTIAL); // One front-to-back pass
+            file->data = addr;
+            file->size = (size_t)st.st_size;
+            file->mapped = true;
+            close(fd);
+            return true;
+        }
+    }
+    // Not a regular file or mmap failed: read it all
+    size_t capacity = 1 << 16, size = 0;
+    char *buffer = malloc(capacity);
+    ssize_t n = 0;
+    while (buffer && (n = read(fd, buffer + size, capacity - size)) > 0) {
+        size += (size_t)n;
+        if (size == capacity) {
+            char *grown = realloc(buffer, capacity * 2);
+            if (!grown) { free(buffer); buffer = NULL; break; }
+            buffer = grown;
+            capacity *= 2;
+        }
+    }
+    close(fd);
+    if (!buffer || n < 0) {
+        free(buffer);
+        return false;
+    }
+    file->data = buffer;
+    file->size = size;
+    return true;
+}
+
+void unmapInputFile(MappedFile *file) {
+    if (!file || !file->data) return;
+    if (file->mapped) munmap((void*)file->data, file->size);
+    else free((void*)file->data);
+    file->data = NULL;
+    file->size = 0;
+}
+
+// Same as trim_whitespace, without writing a terminator
+TextSpan trimSpan(TextSpan s) {
+    while (s.len > 0 && isspace((unsigned char)s.p[0])) { s.p++; s.len--; }
+    while (s.len > 0 && isspace((unsigned char)s.p[s.len - 1])) s.len--;
+    return s;
+}
+
+bool spanEquals(TextSpan s, const char *literal, bool ignore_case) {
+    size_t n = strlen(literal);
+    if (s.len != n) return false;
+    return ignore_case ? strncasecmp(s.p, literal, n) == 0 : memcmp(s.p, literal, n) == 0;
+}
+
+// Copies a span into a NUL-terminated buffer for the libc fallbacks (truncates if too long)
+void copySpan(TextSpan s, char *buffer, size_t buffer_size) {
+    size_t n = s.len < buffer_size - 1 ? s.len : buffer_size - 1;
+    memcpy(buffer, s.p, n);
+    buffer[n] = '\0';
+}
+
+// Reads 'count' ASCII digits at p; -1 if any of them is not a digit
+int spanDigits(const char *p, int count) {
+    int value = 0;
+    for (int i = 0; i < count; i++) {
+        unsigned d = (unsigned char)p[i] - '0';
+        if (d > 9) return -1;
+        value = value * 10 + (int)d;
+    }
+    return value;
+}
+
+// atoi on a span. Up to 9 digits are converted inline; longer numbers go through strtol.
+int parseSpanInt(TextSpan s) {
+    size_t i = 0;
+    bool negative = false;
+    if (i < s.len && (s.p[i] == '-' || s.p[i] == '+')) negative = (s.p[i++] == '-');
+    int value = 0, digits = 0;
+    while (i < s.len && (unsigned)((unsigned char)s.p[i] - '0') <= 9) {
+        if (++digits > 9) {
+            char buffer[64];
+            copySpan(s, buffer, sizeof(buffer));
+            return (int)strtol(buffer, NULL, 10);
+        }
+        value = value * 10 + (s.p[i++] - '0');
+    }
+    return negative ? -value : value;
+}
+
+// atof on a span. Plain decimals with up to 15 significant digits are m / 10^k, which is exact in
+// both operands and therefore correctly rounded, the same as strtod. Anything else (exponents,
+// hex, inf/nan, trailing text, long mantissas) goes through strtod.
+double parseSpanDecimal(TextSpan s) {
+    static const double powers_of_ten[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7,
+                                           1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15};
+    size_t i = 0;
+    bool negative = false;
+    if (i < s.len && (s.p[i] == '-' || s.p[i] == '+')) negative = (s.p[i++] == '-');
+    uint64_t mantissa = 0;
+    int digits = 0, fraction_digits = 0;
+    bool in_fraction = false;
+    for (; i < s.len; i++) {
+        unsigned d = (unsigned char)s.p[i] - '0';
+        if (d <= 9) {
+            mantissa = mantissa * 10 + d;
+            digits++;
+            if (in_fraction) fraction_digits++;
+        } else if (s.p[i] == '.' && !in_fraction) {
+            in_fraction = true;
+        } else {
+            break;
+        }
+    }
+    if (i == s.len && digits > 0 && digits <= 15) {
+        double value = (double)mantissa / powers_of_ten[fraction_digits];
+        return negative ? -value : value;
+    }
+    char buffer[64];
+    copySpan(s, buffer, sizeof(buffer));
+    return atof(buffer);
+}
+
+// parseDateTimeString on spans. The usual "DD-MM-YYYY", "HH:MM[:SS]", "AM|PM" is decoded inline;
+// anything unusual is copied out and handed to parseDateTimeString so its checks and messages apply.
+time_t parseSpanDateTime(TextSpan date, TextSpan time, TextSpan ampm) {
+    if (spanEquals(date, "none", false) || spanEquals(time, "none", false) ||
+        spanEquals(ampm, "none", false) || spanEquals(ampm, "nonnone", false)) {
+        return 0;
+    }
+    int day = -1, month = -1, year = -1, hour = -1, min = -1;
+    if (date.len == 10 && date.p[2] == '-' && date.p[5] == '-') {
+        day = spanDigits(date.p, 2);
+        month = spanDigits(date.p + 3, 2);
+        year = spanDigits(date.p + 6, 4);
+    }
+    int hour_digits = (time.len >= 2 && time.p[1] == ':') ? 1 : 2;
+    if ((time.len == (size_t)hour_digits + 3 || time.len == (size_t)hour_digits + 6) && time.p[hour_digits] == ':') {
+        hour = spanDigits(time.p, hour_digits);
+        min = spanDigits(time.p + hour_digits + 1, 2); // Seconds are ignored, as in parseDateTimeString
+    }
+    bool pm = spanEquals(ampm, "PM", true);
+    if (day < 0 || month < 0 || year < 1900 || hour < 1 || hour > 12 || min < 0 || min > 59 ||
+        (!pm && !spanEquals(ampm, "AM", true))) {
+        char date_buf[32], time_buf[32], ampm_buf[32];
+        copySpan(date, date_buf, sizeof(date_buf));
+        copySpan(time, time_buf, sizeof(time_buf));
+        copySpan(ampm, ampm_buf, sizeof(ampm_buf));
+        return parseDateTimeString(date_buf, time_buf, ampm_buf);
+    }
+    if (pm && hour != 12) hour += 12;
+    else if (!pm && hour == 12) hour = 0; // 12 AM -> 00:xx
+    time_t result = localDateTimeToEpoch(year, month, day, hour, min, 0);
+    return result == -1 ? 0 : result;
+}
+
+// Tokenizes one data line [line, end) of the mapped input into rec. Returns false if the line is
+// skipped (rec->status says why; the caller logs it so loader threads never write the log).
+// Fields are split on tabs with strtok semantics (runs of tabs count as one separator).
+bool parseInitialRecordSpan(const char *line, const char *end, int line_num, InitialRecord *rec) {
+    TextSpan fields[14];
+    int field_count = 0;
+    const char *p = line;
+    while (field_count < 14) {
+        while (p < end && *p == '\t') p++;
+        if (p == end) break;
+        const char *tab = memchr(p, '\t', (size_t)(end - p));
+        const char *stop = tab ? tab : end;
+        fields[field_count++] = trimSpan((TextSpan){p, (size_t)(stop - p)});
+        p = stop;
+    }
+
+    memset(rec, 0, sizeof(*rec));
+    rec->line_num = line_num;
+    rec->field_count = field_count;
+    if (field_count < 14) {
+        rec->status = RECORD_TOO_FEW_FIELDS;
+        return false;
+    }
+
+    // Extract data with basic validation
+    TextSpan vnum = fields[0];
+    if (vnum.len == 0 || vnum.len >= sizeof(rec->vehicle_number)) {
+         rec->status = RECORD_BAD_PLATE;
+         return false;
+    }
+    memcpy(rec->vehicle_number, vnum.p, vnum.len);
+    size_t owner_len = fields[1].len < sizeof(rec->owner_name) - 1 ? fields[1].len : sizeof(rec->owner_name) - 1;
+    memcpy(rec->owner_name, fields[1].p, owner_len);
+    rec->arrival_time = parseSpanDateTime(fields[2], fields[3], fields[4]);
+    rec->departure_time = parseSpanDateTime(fields[5], fields[6], fields[7]);
+    rec->departure_none = spanEquals(fields[5], "none", false);
+
+    // Set membership from file string
+    if (spanEquals(fields[8], "golden", true)) rec->membership = GOLD;
+    else if (spanEquals(fields[8], "premium", true)) rec->membership = PREMIUM;
+    else rec->membership = NO_MEMBERSHIP;
+
+    rec->space_id = parseSpanInt(fields[9]);
+    rec->parkings_done = parseSpanInt(fields[10]);
+    rec->amount_paid = parseSpanDecimal(fields[11]);
+    rec->occupancy = parseSpanInt(fields[12]); // For the space
+    rec->max_revenue = parseSpanDecimal(fields[13]); // For the space
+    return true;
+}
+
+// Logs why a staged line was skipped
+void logSkippedRecord(const InitialRecord *rec, int line_num) {
+    if (rec->status == RECORD_TOO_FEW_FIELDS) {
+       // fprintf(stderr, "Warning: Skipping line %d in '%s' due to insufficient fields (%d found, expected 14).\n", line_num, INPUT_FILENAME, rec->field_count);
+        logWarn("Warning: Skipping line %d due to insufficient fields (%d found).\n", line_num, rec->field_count);
+    } else if (rec->status == RECORD_BAD_PLATE) {
+         logWarn("Warning: Skipping line %d due to invalid vehicle number.\n", line_num);
+    }
+}
+
+// Applies one staged input line to its vehicle and parking space, in file order
+void applyInitialRecord(const InitialRecord *rec, SpaceTable *spaces) {
+    Vehicle *v = rec->vehicle;
+    int line_num = rec->line_num;
+    int space_id = rec->space_id;
+    if (rec->is_repeat) {
+         logWarn("Warning: Vehicle %s found multiple times in file (line %d). Updating data.\n", v->vehicle_number, line_num);
+    }
+
+    // Update vehicle details
+    safe_strcpy(v->owner_name, rec->owner_name, sizeof(v->owner_name));
+    v->num_parkings = rec->parkings_done > 0 ? rec->parkings_done : v->num_parkings; // Keep existing if file has 0?
+    v->total_amount_paid = rec->amount_paid > 0 ? rec->amount_paid : v->total_amount_paid; // Keep existing if file has 0?
+    v->membership = rec->membership;
+
+    if (v->total_parking_hours <= 0.1) { 
+        if (v->membership == GOLD) v->total_parking_hours = fmax(200.0, v->num_parkings * 2.0);
+        else if (v->membership == PREMIUM) v->total_parking_hours = fmax(100.0, v->num_parkings * 2.0);
+        else if (v->total_amount_paid > 100) v->total_parking_hours = fmax(1.0, (v->total_amount_paid / 60.0));
+        else v->total_parking_hours = fmax(0.0, v->num_parkings * 1.5);
+    }
+    updateMembership(v); // Re-validate membership based on estimated hours/stats
+
+    bool is_parked_in_file = (rec->departure_none && space_id > 0 && space_id <= spaces->count);
+
+    if (space_id > 0 && space_id <= spaces->count) {
+        ParkingSpace *ps = lookupSpace(spaces, space_id);
+        if (ps) {
+            // Update space stats from file (take the values from the latest line for this space)
+            ps->occupancy_count = rec->occupancy >= 0 ? rec->occupancy : ps->occupancy_count;
+            ps->total_revenue = rec->max_revenue >= 0 ? rec->max_revenue : ps->total_revenue;
+
+            if (is_parked_in_file) {
+                if (ps->status == 0) {
+                    setSpaceStatus(spaces, ps, 1); // Mark space occupied
+                    safe_strcpy(ps->parked_vehicle_num, v->vehicle_number, sizeof(ps->parked_vehicle_num));
+                    v->current_parking_space_id = ps->space_id;
+                    // Use arrival time from file if valid, else assume NOW
+                    v->arrival_time = rec->arrival_time;
+                    if (v->arrival_time == 0) {
+                         logWarn("Warning: Invalid arrival time for parked vehicle %s in file (line %d). Setting arrival to NOW.\n", v->vehicle_number, line_num);
+                         v->arrival_time = clockNow(&parkingClock);
+                    }
+                    v->last_departure_time = 0;
+                    char time_buf[30]; formatTime(v->arrival_time, time_buf, sizeof(time_buf));
+                    logInfo("Info: Vehicle %s marked as parked in space %d at %s (from file line %d).\n", v->vehicle_number, ps->space_id, time_buf, line_num);
+                } else if (strcmp(ps->parked_vehicle_num, v->vehicle_number) != 0) {
+                    // Space occupied, but by a DIFFERENT vehicle according to previous lines/state
+                    fprintf(stderr, "Warning: File conflict line %d - Space %d for %s already occupied by %s. Vehicle %s not parked.\n",
+                            line_num, space_id, v->vehicle_number, ps->parked_vehicle_num, v->vehicle_number);
+                    logWarn("Warning: File conflict line %d - Space %d for %s already occupied by %s. Vehicle %s not parked.\n",
+                            line_num, space_id, v->vehicle_number, ps->parked_vehicle_num, v->vehicle_number);
+                    v->current_parking_space_id = -1;
+                    v->arrival_time = 0;
+                } else {
+                     // Space occupied by the SAME vehicle. Update arrival time if file has a valid one.
+                     if (rec->arrival_time != 0) {
+                         v->arrival_time = rec->arrival_time;
+                         char time_buf[30]; formatTime(v->arrival_time, time_buf, sizeof(time_buf));
+                          logInfo("Info: Updated arrival time for already parked vehicle %s in space %d to %s (from file line %d).\n", v->vehicle_number, ps->space_id, time_buf, line_num);
+                     }
+                }
+            } else { // Vehicle is NOT parked according to this line
+                 // If space *was* marked occupied by *this* vehicle, free it.
+                 if (ps->status == 1 && strcmp(ps->parked_vehicle_num, v->vehicle_number) == 0) {
+                      logInfo("Info: File line %d indicates %s departed space %d. Marking space free.\n", line_num, v->vehicle_number, ps->space_id);
+                      setSpaceStatus(spaces, ps, 0);
+                      safe_strcpy(ps->parked_vehicle_num, "", sizeof(ps->parked_vehicle_num));
+                      v->last_departure_time = rec->departure_time;
+                      v->current_parking_space_id = -1;
+                      v->arrival_time = 0;
+                 }
+            }
+        } else {
+           //  fprintf(stderr, "CRITICAL Error: Space %d not found in tree during load (line %d).\n", space_id, line_num);
+             logError("CRITICAL Error: Space %d not found in space table during load (line %d).\n", space_id, line_num);
+        }
+    } else if (is_parked_in_file) {
+      //   fprintf(stderr, "Error: File line %d indicates vehicle %s parked in invalid space %d. Marking as not parked.\n", line_num, v->vehicle_number, space_id);
+         logError("Error: File line %d indicates vehicle %s parked in invalid space %d. Marking as not parked.\n", line_num, v->vehicle_number, space_id);
+         is_parked_in_file = false; 
+    }
+
+    if (!is_parked_in_file && v->current_parking_space_id != -1) {
+         if (v->current_parking_space_id > 0) { 
+             logInfo("Info: Correcting state for vehicle %s - marking as not parked based on file line %d.\n", v->vehicle_number, line_num);
+         }
+         v->current_parking_space_id = -1;
+         v->arrival_time = 0;
+         // Set last departure time if available and not currently parked
+         if (!rec->departure_none) {
+              v->last_departure_time = rec->departure_time;
+         }
+    }
+}
+
+// Automatic thread count: one per online CPU, but no more threads than LOAD_MIN_CHUNK_BYTES slices
+int chooseLoadThreads(size_t input_bytes, int requested) {
+    int threads = requested;
+    if (threads <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        size_t slices = input_bytes / LOAD_MIN_CHUNK_BYTES;
+        threads = cpus > 0 ? (int)cpus : 1;
+        if ((size_t)threads > slices) threads = slices > 0 ? (int)slices : 1;
+    }
+    return threads > LOAD_MAX_THREADS ? LOAD_MAX_THREADS : threads;
+}
+
+// Parses one slice into the chunk's own record vector and sorts its parsed records by plate.
+// Touches nothing shared: no log output, no tree or table access.
+void* loadChunkWorker(void *arg) {
+    LoadChunk *chunk = arg;
+    int newlines = 0;
+    for (const char *p = chunk->begin; p < chunk->end && (p = memchr(p, '\n', (size_t)(chunk->end - p))); p++) newlines++;
+    chunk->records = malloc((size_t)(newlines + 1) * sizeof(InitialRecord));
+    chunk->sorted = malloc((size_t)(newlines + 1) * sizeof(InitialRecord*));
+    if (!chunk->records || !chunk->sorted) {
+        chunk->failed = true;
+        return NULL;
+    }
+    const char *cursor = chunk->begin;
+    while (cursor < chunk->end) {
+        const char *eol = memchr(cursor, '\n', (size_t)(chunk->end - cursor));
+        const char *line_end = eol ? eol : chunk->end;
+        chunk->lines++;
+        if (line_end > cursor) {
+            InitialRecord *rec = &chunk->records[chunk->count++];
+            if (parseInitialRecordSpan(cursor, line_end, chunk->lines, rec)) chunk->sorted[chunk->sorted_count++] = rec;
+            else chunk->skipped++;
+        }
+        cursor = eol ? eol + 1 : chunk->end;
+    }
+    qsort(chunk->sorted, chunk->sorted_count, sizeof(InitialRecord*), compare_initial_records);
+    return NULL;
+}
+
+bool loadInitialData(BPlusTree *vehicleTree, SpaceTable *spaces) {
+    return loadInitialDataFrom(vehicleTree, spaces, INPUT_FILENAME, 0);
+}
+
+// Loads vehicles and their space state. Input rows are staged and sorted once so the vehicle tree
+// can be bulk-built bottom-up instead of paying a descent, duplicate scan and splits per row.
+// Parsing and sorting run on up to 'threads' workers, one per newline-aligned slice of the file;
+// everything that touches the trees, the space table or the log stays on the calling thread.
+// Returns false when the load fails (out of memory); the tree and spaces are then left as they
+// were. A missing or empty file is not a failure: there is simply nothing to load.
+bool loadInitialDataFrom(BPlusTree *vehicleTree, SpaceTable *spaces, const char *path, int threads) {
+    if (!vehicleTree || !spaces || !spaces->spaces) {
+     //   fprintf(stderr, "Error: Invalid tree pointers passed to loadInitialData.\n");
+        logError("Error: Invalid tree/space table passed to loadInitialData.\n");
+        return false;
+    }
+    MappedFile input;
+    if (!mapInputFile(path, &input)) {
+        perror("Error: Could not open initial data file");
+        logWarn("Warning: Input data file '%s' not found. Starting with empty vehicle data.\n", path);
+        return true; // No vehicle data to load
+    }
+
+    logInfo("Loading initial data from %s...\n", path);
+
+    const char *cursor = input.data;
+    const char *file_end = input.data + input.size;
+    // Skip header line
+    if (input.size == 0) {
+        // fprintf(stderr, "Warning: Input file '%s' is empty or contains only header.\n", path);
+         logWarn("Warning: Input file '%s' is empty or contains only header.\n", path);
+         unmapInputFile(&input);
+         return true;
+    }
+    const char *eol = memchr(cursor, '\n', input.size);
+    cursor = eol ? eol + 1 : file_end;
+
+    // Pass 1 (parallel): split the body into newline-aligned slices and parse each on its own thread
+    int chunk_count = chooseLoadThreads((size_t)(file_end - cursor), threads);
+    LoadChunk *chunks = calloc((size_t)chunk_count, sizeof(LoadChunk));
+    pthread_t *workers = malloc((size_t)chunk_count * sizeof(pthread_t));
+    bool *started = calloc((size_t)chunk_count, sizeof(bool));
+    if (!chunks || !workers || !started) {
+        logError(" Failed to allocate staging records for initial load.\n");
+        free(chunks); free(workers); free(started);
+        unmapInputFile(&input);
+        return false;
+    }
+    for (int c = 0; c < chunk_count; c++) {
+        chunks[c].begin = c == 0 ? cursor : chunks[c - 1].end;
+        const char *split = cursor + (size_t)(file_end - cursor) * (size_t)(c + 1) / (size_t)chunk_count;
+        if (c == chunk_count - 1 || split <= chunks[c].begin) {
+            split = c == chunk_count - 1 ? file_end : chunks[c].begin;
+        } else {
+            const char *nl = memchr(split - 1, '\n', (size_t)(file_end - split + 1));
+            split = nl ? nl + 1 : file_end;
+        }
+        chunks[c].end = split;
+    }
+    tzset(); // Initialise timezone state before the workers call mktime
+    for (int c = 1; c < chunk_count; c++) { // Slice 0 runs on this thread
+        started[c] = pthread_create(&workers[c], NULL, loadChunkWorker, &chunks[c]) == 0;
+    }
+    loadChunkWorker(&chunks[0]);
+    for (int c = 1; c < chunk_count; c++) {
+        if (started[c]) pthread_join(workers[c], NULL);
+        else loadChunkWorker(&chunks[c]); // Could not start a thread: parse it here
+    }
+    free(workers);
+    free(started);
+    unmapInputFile(&input); // Records hold copies of every field they need
+
+    int record_count = 0;
+    bool failed = false;
+    for (int c = 0; c < chunk_count; c++) {
+        chunks[c].first_line = c == 0 ? 1 : chunks[c - 1].first_line + chunks[c - 1].lines; // Line 1 is the header
+        record_count += chunks[c].sorted_count;
+        failed |= chunks[c].failed;
+    }
+    // Skipped lines are reported in file order, as a sequential parse would
+    for (int c = 0; c < chunk_count && !failed; c++) {
+        for (int i = 0; chunks[c].skipped > 0 && i < chunks[c].count; i++) {
+            if (chunks[c].records[i].status != RECORD_PARSED) logSkippedRecord(&chunks[c].records[i], chunks[c].first_line + chunks[c].records[i].line_num);
+        }
+    }
+
+    // Pass 2: merge the per-slice orders (ties go to the earlier slice, so equal plates stay in
+    // file order) and attach one Vehicle to every run of equal plates
+    InitialRecord **sorted = malloc((record_count > 0 ? record_count : 1) * sizeof(InitialRecord*));
+    // Keys of the new plates are staged by value; the bulk load copies them into the nodes
+    PlateKey *new_plates = malloc((record_count > 0 ? record_count : 1) * sizeof(PlateKey));
+    void **new_keys = malloc((record_count > 0 ? record_count : 1) * sizeof(void*));
+    void **new_vehicles = malloc((record_count > 0 ? record_count : 1) * sizeof(void*));
+    if (failed || !sorted || !new_plates || !new_keys || !new_vehicles) {
+        logError(" Failed to allocate sort buffers for initial load.\n");
+        free(sorted); free(new_plates); free(new_keys); free(new_vehicles);
+        for (int c = 0; c < chunk_count; c++) { free(chunks[c].records); free(chunks[c].sorted); }
+        free(chunks);
+        return false;
+    }
+    int heads[LOAD_MAX_THREADS] = {0};
+    for (int i = 0; i < record_count; i++) {
+        int best = -1;
+        for (int c = 0; c < chunk_count; c++) {
+            if (heads[c] == chunks[c].sorted_count) continue;
+            if (best < 0 || strcmp(chunks[c].sorted[heads[c]]->vehicle_number, chunks[best].sorted[heads[best]]->vehicle_number) < 0) best = c;
+        }
+        sorted[i] = chunks[best].sorted[heads[best]++];
+    }
+
+    int new_count = 0;
+    bool out_of_memory = false;
+    for (int i = 0; i < record_count && !out_of_memory; i++) {
+        InitialRecord *rec = sorted[i];
+        if (i > 0 && strcmp(sorted[i - 1]->vehicle_number, rec->vehicle_number) == 0) {
+            rec->vehicle = sorted[i - 1]->vehicle;
+            rec->is_repeat = true;
+            continue;
+        }
+        Vehicle *v = lookupVehicle(vehicleTree, rec->vehicle_number);
+        if (v) { // Already in the tree before this load
+            rec->is_repeat = true;
+        } else {
+            v = (Vehicle*)calloc(1, sizeof(Vehicle));
+            if (!v) {
+            //    perror(" Memory allocation failed for vehicle struct during load");
+                logError(" Memory allocation failed for vehicle struct %s. Load aborted.\n", rec->vehicle_number);
+                out_of_memory = true;
+                break;
+            }
+            safe_strcpy(v->vehicle_number, rec->vehicle_number, sizeof(v->vehicle_number));
+            new_plates[new_count] = makePlateKey(v->vehicle_number);
+            new_keys[new_count] = &new_plates[new_count];
+            new_vehicles[new_count] = v;
+            new_count++;
+        }
+        rec->vehicle = v;
+    }
+    if (out_of_memory) { // Nothing has been applied yet: drop the new vehicles and the staging data
+        for (int i = 0; i < new_count; i++) free_vehicle_data(new_vehicles[i]);
+        free(sorted); free(new_plates); free(new_keys); free(new_vehicles);
+        for (int c = 0; c < chunk_count; c++) { free(chunks[c].records); free(chunks[c].sorted); }
+        free(chunks);
+        logFlush();
+        return false;
+    }
+
+    // Pass 3: replay lines in file order so later lines override earlier ones
+    for (int c = 0; c < chunk_count; c++) {
+        for (int i = 0; i < chunks[c].count; i++) {
+            InitialRecord *rec = &chunks[c].records[i];
+            if (rec->status != RECORD_PARSED) continue;
+            rec->line_num += chunks[c].first_line;
+            applyInitialRecord(rec, spaces);
+        }
+    }
+
+    // New plates are already in key order: build the vehicle tree in one pass
+    if (!bulkLoadBPlusTree(vehicleTree, new_keys, new_vehicles, new_count, BULK_LOAD_FILL_FACTOR)) {
+        for (int i = 0; i < new_count; i++) {
+            insertPlateTree(vehicleTree, new_plates[i], new_vehicles[i]); // Tree owns data
+        }
+    }
+
+    free(sorted);
+    free(new_plates);
+    free(new_keys);
+    free(new_vehicles);
+    for (int c = 0; c < chunk_count; c++) {
+        free(chunks[c].records);
+        free(chunks[c].sorted);
+    }
+    free(chunks);
+    if (vehicleTree->amount_index) buildAmountIndex(vehicleTree); // Amounts were overwritten
+    logInfo("Initial data loading complete.\n");
+    return true;
+}
+
+
+// --- Log Writer ---
+
+// Asks the writer thread to drain now
+void logWake() {
+    pthread_mutex_lock(&logWriter.mutex);
+    logWriter.wake_requested = true;
+    pthread_cond_signal(&logWriter.wake);
+    pthread_mutex_unlock(&logWriter.mutex);
+}
+
+// Takes the producer flag. The spin issues a pause hint and yields the CPU after a few rounds, so
+// a holder that was preempted gets to run instead of competing with the spinners.
+void logProducerLock() {
+    int spins = 0;
+    while (atomic_flag_test_and_set_explicit(&logWriter.producer_lock, memory_order_acquire)) {
+        if (++spins < 64) {
+#if PARKING_X86_SIMD
+            _mm_pause();
+#endif
+        } else {
+            sched_yield();
+            spins = 0;
+        }
+    }
+}
+
+void logProducerUnlock() {
+    atomic_flag_clear_explicit(&logWriter.producer_lock, memory_order_release);
+}
+
+// Copies as much of data as fits into the ring and returns the byte count. Caller holds producer_lock.
+size_t logRingPut(const char *data, size_t len) {
+    LogWriter *w = &logWriter;
+    size_t head = atomic_load_explicit(&w->head, memory_order_relaxed);
+    size_t copied = 0;
+    while (copied < len) {
+        size_t used = head - atomic_load_explicit(&w->tail, memory_order_acquire);
+        if (used == w->capacity) break;
+        size_t offset = head & (w->capacity - 1);
+        size_t chunk = w->capacity - used;
+        if (chunk > w->capacity - offset) chunk = w->capacity - offset; // Up to the wrap point
+        if (chunk > len - copied) chunk = len - copied;
+        memcpy(w->ring + offset, data + copied, chunk);
+        copied += chunk;
+        head += chunk;
+        atomic_store_explicit(&w->head, head, memory_order_release);
+    }
+    return copied;
+}
+
+// Sleeps until the ring has 'needed' free bytes. Called without producer_lock, so other
+// producers are never stalled behind a full ring.
+void logRingWait(size_t needed) {
+    LogWriter *w = &logWriter;
+    pthread_mutex_lock(&w->mutex);
+    w->wake_requested = true;
+    pthread_cond_signal(&w->wake);
+    while (w->capacity - (atomic_load_explicit(&w->head, memory_order_acquire) -
+                          atomic_load_explicit(&w->tail, memory_order_acquire)) < needed) {
+        pthread_cond_wait(&w->drained, &w->mutex);
+    }
+    pthread_mutex_unlock(&w->mutex);
+}
+
+void logPrintf(const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    if (!logWriter.running) { // Synchronous until logStart
+        vfprintf(outputFile, format, args);
+        va_end(args);
+        return;
+    }
+    char line[LOG_LINE_MAX];
+    char *text = line;
+    va_list copy;
+    va_copy(copy, args);
+    int len = vsnprintf(line, sizeof(line), format, args);
+    if (len >= (int)sizeof(line)) { // Rare long line (e.g. a long file path): format on the heap
+        text = malloc((size_t)len + 1);
+        if (text) vsnprintf(text, (size_t)len + 1, format, copy);
+        else { text = line; len = sizeof(line) - 1; } // Keep the truncated line
+    }
+    va_end(copy);
+    va_end(args);
+    if (len <= 0) return;
+
+    // A line that fits the ring goes in whole, so lines from different threads never interleave.
+    // When it does not fit yet the flag is dropped while waiting for the writer.
+    size_t total = (size_t)len, done = 0, before = 0;
+    while (done < total) {
+        logProducerLock();
+        size_t used = atomic_load_explicit(&logWriter.head, memory_order_relaxed) - atomic_load_explicit(&logWriter.tail, memory_order_acquire);
+        if (done == 0) before = used;
+        bool whole_line_waits = done == 0 && total <= logWriter.capacity && logWriter.capacity - used < total;
+        if (!whole_line_waits) done += logRingPut(text + done, total - done);
+        logProducerUnlock();
+        if (done < total) {
+            size_t rest = total - done;
+            logRingWait(rest < logWriter.capacity ? rest : logWriter.capacity);
+        }
+    }
+    if (text != line) free(text);
+
+    // Size policy: wake the writer when this line crossed the threshold
+    if (logWriter.policy.mode == LOG_FLUSH_SIZE && before < logWriter.policy.size_bytes &&
+        before + (size_t)len >= logWriter.policy.size_bytes) {
+        logWake();
+    }
+}
+
+// Writes everything pending to outputFile with one fwrite per contiguous segment, then fflushes
+void logDrain(LogWriter *w) {
+    size_t tail = atomic_load_explicit(&w->tail, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&w->head, memory_order_acquire);
+    while (tail != head) {
+        size_t offset = tail & (w->capacity - 1);
+        size_t chunk = head - tail;
+        if (chunk > w->capacity - offset) chunk = w->capacity - offset;
+        fwrite(w->ring + offset, 1, chunk, outputFile);
+        tail += chunk;
+        atomic_store_explicit(&w->tail, tail, memory_order_release);
+    }
+    fflush(outputFile);
+    atomic_store_explicit(&w->flushed, head, memory_order_release);
+}
+
+void* logWriterMain(void *arg) {
+    LogWriter *w = arg;
+    pthread_mutex_lock(&w->mutex);
+    for (;;) {
+        if (!w->wake_requested && !w->stop) {
+            if (w->policy.mode == LOG_FLUSH_TIME) {
+                struct timespec deadline;
+                clock_gettime(CLOCK_REALTIME, &deadline);
+                deadline.tv_sec += w->policy.interval_ms / 1000;
+                deadline.tv_nsec += (long)(w->policy.interval_ms % 1000) * 1000000L;
+                if (deadline.tv_nsec >= 1000000000L) { deadline.tv_sec++; deadline.tv_nsec -= 1000000000L; }
+                pthread_cond_timedwait(&w->wake, &w->mutex, &deadline);
+            } else {
+                while (!w->wake_requested && !w->stop) pthread_cond_wait(&w->wake, &w->mutex);
+            }
+        }
+        bool stopping = w->stop;
+        w->wake_requested = false;
+        pthread_mutex_unlock(&w->mutex);
+        logDrain(w);
+        pthread_mutex_lock(&w->mutex);
+        pthread_cond_broadcast(&w->drained);
+        if (stopping && atomic_load(&w->tail) == atomic_load(&w->head)) break;
+    }
+    pthread_mutex_unlock(&w->mutex);
+    return NULL;
+}
+
+bool logStart(const LogFlushPolicy *policy) {
+    LogWriter *w = &logWriter;
+    if (w->running || !outputFile) return false;
+    LogFlushPolicy p = policy ? *policy : (LogFlushPolicy){LOG_FLUSH_PER_OP, 0, 0, 0};
+    size_t capacity = 4096;
+    size_t wanted = p.ring_bytes ? p.ring_bytes : LOG_RING_DEFAULT_BYTES;
+    while (capacity < wanted) capacity <<= 1;
+    if (p.mode == LOG_FLUSH_TIME && p.interval_ms <= 0) p.interval_ms = 100;
+    if (p.mode == LOG_FLUSH_SIZE && (p.size_bytes == 0 || p.size_bytes > capacity / 2)) p.size_bytes = capacity / 2;
+
+    w->ring = malloc(capacity);
+    if (!w->ring) return false;
+    w->capacity = capacity;
+    w->policy = p;
+    atomic_store(&w->head, 0);
+    atomic_store(&w->tail, 0);
+    atomic_store(&w->flushed, 0);
+    w->wake_requested = false;
+    w->stop = false;
+    setvbuf(outputFile, logSinkBuffer, _IOFBF, sizeof(logSinkBuffer)); // Only the writer touches it from now on
+    w->running = true;
+    if (pthread_create(&w->thread, NULL, logWriterMain, w) != 0) {
+        w->running = false;
+        free(w->ring);
+        w->ring = NULL;
+        return false;
+    }
+    return true;
+}
+
+void logOpEnd() {
+    if (logWriter.running && logWriter.policy.mode == LOG_FLUSH_PER_OP) logWake();
+}
+
+void logFlush() {
+    LogWriter *w = &logWriter;
+    if (!w->running) {
+        if (outputFile) fflush(outputFile);
+        return;
+    }
+    size_t target = atomic_load_explicit(&w->head, memory_order_acquire);
+    pthread_mutex_lock(&w->mutex);
+    w->wake_requested = true;
+    pthread_cond_signal(&w->wake);
+    while (atomic_load_explicit(&w->flushed, memory_order_acquire) < target) {
+        pthread_cond_wait(&w->drained, &w->mutex);
+    }
+    pthread_mutex_unlock(&w->mutex);
+}
+
+void logStop() {
+    LogWriter *w = &logWriter;
+    if (!w->running) return;
+    pthread_mutex_lock(&w->mutex);
+    w->stop = true;
+    pthread_cond_signal(&w->wake);
+    pthread_mutex_unlock(&w->mutex);
+    pthread_join(w->thread, NULL);
+    w->running = false;
+    free(w->ring);
+    w->ring = NULL;
+}
+
+// Parses a --log-flush argument; false (policy untouched) if the spec is not recognised
+bool parseLogFlushSpec(const char *spec, LogFlushPolicy *policy) {
+    if (!spec || !policy) return false;
+    char *end = NULL;
+    if (strcmp(spec, "op") == 0) {
+        policy->mode = LOG_FLUSH_PER_OP;
+    } else if (strncmp(spec, "time:", 5) == 0) {
+        long ms = strtol(spec + 5, &end, 10);
+        if (end == spec + 5 || *end != '\0' || ms <= 0 || ms > 60000) return false;
+        policy->mode = LOG_FLUSH_TIME;
+        policy->interval_ms = (int)ms;
+    } else if (strncmp(spec, "size:", 5) == 0) {
+        long bytes = strtol(spec + 5, &end, 10);
+        if (end == spec + 5 || *end != '\0' || bytes <= 0) return false;
+        policy->mode = LOG_FLUSH_SIZE;
+        policy->size_bytes = (size_t)bytes;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// Parses a --log-level argument (case-insensitive); false (level untouched) if not recognised
+bool parseLogLevel(const char *name, LogLevel *level) {
+    static const char *names[] = {"error", "warn", "info", "debug", "trace"};
+    if (!name || !level) return false;
+    for (int i = 0; i < (int)(sizeof(names) / sizeof(names[0])); i++) {
+        if (strcasecmp(name, names[i]) == 0) {
+            *level = (LogLevel)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+// --- Clock ---
+
+time_t clockNow(const ParkingClock *clock) {
+    if (!clock || clock->mode == PARKING_CLOCK_WALL) return time(NULL);
+    return clock->now;
+}
+
+void setClockWall(ParkingClock *clock) {
+    clock->mode = PARKING_CLOCK_WALL;
+    clock->now = 0;
+}
+
+void setClockFixed(ParkingClock *clock, time_t now) {
+    clock->mode = PARKING_CLOCK_FIXED;
+    clock->now = now;
+}
+
+void setClockEvent(ParkingClock *clock) {
+    clock->mode = PARKING_CLOCK_EVENT;
+    clock->now = 0;
+}
+
+// Event timestamps are taken as given (not forced monotonic): each event is charged at its own time
+void clockObserveEvent(ParkingClock *clock, time_t event_time) {
+    if (clock && clock->mode == PARKING_CLOCK_EVENT) clock->now = event_time;
+}
+
+// Parses a --clock argument into clock; false (clock untouched) if the spec is not recognised
+bool parseClockSpec(const char *spec, ParkingClock *clock) {
+    if (!spec || !clock) return false;
+    if (strcmp(spec, "wall") == 0) {
+        setClockWall(clock);
+    } else if (strcmp(spec, "event") == 0) {
+        setClockEvent(clock);
+    } else if (strncmp(spec, "fixed:", 6) == 0) {
+        time_t fixed = parseUserInputDateTime(spec + 6);
+        if (fixed == 0) return false;
+        setClockFixed(clock, fixed);
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// --- Lot Configuration ---
+// Default layout: GOLD from space 1, PREMIUM from 11, general from 21, each up to the last space
+// (ranges are clamped for lots smaller than 21 spaces)
+void setDefaultLotConfig(LotConfig *config, int lot_size) {
+    config->lot_size = lot_size;
+    config->gold_first = 1;
+    config->premium_first = lot_size >= 11 ? 11 : 1;
+    config->general_first = lot_size >= 21 ? 21 : 1;
+    config->gold_last = config->premium_last = config->general_last = lot_size;
+}
+
+// Parses "first-last" or "first" (meaning first..lot_size) into a range inside 1..lot_size
+bool parseTierRange(const char *value, int lot_size, int *first, int *last) {
+    int a = 0, b = 0;
+    int fields = sscanf(value, "%d-%d", &a, &b);
+    if (fields == 1) b = lot_size;
+    else if (fields != 2) return false;
+    if (a < 1 || b > lot_size || a > b) return false;
+    *first = a;
+    *last = b;
+    return true;
+}
+
+// Reads "key = value" lines ('#' starts a comment):
+//   lot_size = 5000
+//   gold_range = 1-500       premium_range = 501      general_range = 1001-5000
+// Ranges not given in the file get the default layout for the configured lot size.
+// Invalid lines are reported to outputFile and ignored. Returns false if the file cannot be opened
+// (config is then the default 50-space lot).
+bool loadLotConfig(const char *path, LotConfig *config) {
+    setDefaultLotConfig(config, DEFAULT_LOT_SIZE);
+    FILE *fp = fopen(path, "r");
+    if (!fp) return false;
+
+    // Collect the raw values first: ranges are validated against the final lot size
+    char line[256], gold[64] = "", premium[64] = "", general[64] = "";
+    int lot_size = DEFAULT_LOT_SIZE, line_num = 0;
+    while (fgets(line, sizeof(line), fp)) {
+        line_num++;
+        line[strcspn(line, "#\n")] = 0; // Strip comment and newline
+        char *eq = strchr(line, '=');
+        char *key = trim_whitespace(line);
+        if (*key == '\0') continue;
+        if (!eq) {
+            logWarn("Warning: %s line %d: expected key = value.\n", path, line_num);
+            continue;
+        }
+        *eq = '\0';
+        key = trim_whitespace(key);
+        char *value = trim_whitespace(eq + 1);
+        if (strcmp(key, "lot_size") == 0) {
+            char *end;
+            long n = strtol(value, &end, 10);
+            if (*value == '\0' || *end != '\0' || n < 1 || n > MAX_LOT_SIZE) {
+                logWarn("Warning: %s line %d: lot_size must be 1-%d. Ignored.\n", path, line_num, MAX_LOT_SIZE);
+            } else {
+                lot_size = (int)n;
+            }
+        } else if (strcmp(key, "gold_range") == 0) {
+            safe_strcpy(gold, value, sizeof(gold));
+        } else if (strcmp(key, "premium_range") == 0) {
+            safe_strcpy(premium, value, sizeof(premium));
+        } else if (strcmp(key, "general_range") == 0) {
+            safe_strcpy(general, value, sizeof(general));
+        } else {
+            logWarn("Warning: %s line %d: unknown key '%s'. Ignored.\n", path, line_num, key);
+        }
+    }
+    fclose(fp);
+
+    setDefaultLotConfig(config, lot_size);
+    if (gold[0] && !parseTierRange(gold, lot_size, &config->gold_first, &config->gold_last))
+        logWarn("Warning: %s: invalid gold_range '%s'. Using default.\n", path, gold);
+    if (premium[0] && !parseTierRange(premium, lot_size, &config->premium_first, &config->premium_last))
+        logWarn("Warning: %s: invalid premium_range '%s'. Using default.\n", path, premium);
+    if (general[0] && !parseTierRange(general, lot_size, &config->general_first, &config->general_last))
+        logWarn("Warning: %s: invalid general_range '%s'. Using default.\n", path, general);
+    logInfo("Lot config from %s: %d spaces, GOLD %d-%d, PREMIUM %d-%d, general %d-%d\n", path, lot_size,
+            config->gold_first, config->gold_last, config->premium_first, config->premium_last,
+            config->general_first, config->general_last);
+    return true;
+}
+
+// --- Space Table ---
+// Allocates count spaces (IDs 1..count), all free
+bool initSpaceTable(SpaceTable *table, const LotConfig *config) {
+    int count = config->lot_size;
+    table->view = NULL;
+    table->count = 0;
+    table->layout = *config;
+    logInfo("Initializing %d parking spaces...\n", count);
+    table->spaces = (ParkingSpace*)calloc(count, sizeof(ParkingSpace));
+    table->word_count = (count + 63) / 64;
+    table->free_bits = (uint64_t*)calloc(table->word_count > 0 ? table->word_count : 1, sizeof(uint64_t));
+    table->word_summary = (uint64_t*)calloc((table->word_count + 63) / 64 + 1, sizeof(uint64_t));
+    if (!table->spaces || !table->free_bits || !table->word_summary) {
+      //  perror("FATAL: Memory allocation failed for space table during init");
+        logError("FATAL: Memory allocation failed for %d parking spaces.\n", count);
+        free(table->spaces); free(table->free_bits); free(table->word_summary);
+        table->spaces = NULL; table->free_bits = NULL; table->word_summary = NULL;
+        return false;
+    }
+    for (int i = 1; i <= count; ++i) {
+        ParkingSpace *ps = &table->spaces[i - 1];
+        ps->space_id = i;
+        ps->status = 0; // Free
+        ps->occupancy_count = 0;
+        ps->total_revenue = 0.0;
+        safe_strcpy(ps->parked_vehicle_num, "", sizeof(ps->parked_vehicle_num));
+        table->free_bits[(i - 1) / 64] |= 1ULL << ((i - 1) % 64);
+        table->word_summary[(i - 1) / 4096] |= 1ULL << ((i - 1) / 64 % 64);
+    }
+    table->count = count;
+    logInfo("Space initialization complete.\n");
+    return true;
+}
+
+// Gate-path lookup: one bounds check and an array index, no key allocation or tree descent
+ParkingSpace* lookupSpace(const SpaceTable *table, int space_id) {
+    if (!table || space_id < 1 || space_id > table->count) return NULL;
+    return &table->spaces[space_id - 1];
+}
+
+// Every status change goes through here so the free bitmap never disagrees with the spaces
+void setSpaceStatus(SpaceTable *table, ParkingSpace *ps, int status) {
+    int bit = ps->space_id - 1, w = bit / 64;
+    ps->status = status;
+    if (status == 0) {
+        table->free_bits[w] |= 1ULL << (bit % 64);
+        table->word_summary[w / 64] |= 1ULL << (w % 64);
+    } else {
+        table->free_bits[w] &= ~(1ULL << (bit % 64));
+        if (table->free_bits[w] == 0) table->word_summary[w / 64] &= ~(1ULL << (w % 64));
+    }
+}
+
+// Builds the ordered B+ tree view (space_id -> ParkingSpace*) over the table. The view does not
+// own the spaces (free_data is NULL) and must be rebuilt if the table is reallocated.
+// On false the table has no view.
+bool buildSpaceTreeView(SpaceTable *table) {
+    if (!table || !table->spaces) return false;
+    if (table->view) destroyBPlusTree(table->view);
+    // Keys are copied into the nodes, so the view releases none (free_key is NULL)
+    table->view = createBPlusTree(MIN_DEGREE, sizeof(int), compare_space_keys, NULL, NULL);
+    if (!table->view) return false;
+    setBPlusTreeKeyKind(table->view, KEY_KIND_INT);
+    size_t slots = (size_t)(table->count > 0 ? table->count : 1);
+    int *space_ids = malloc(slots * sizeof(int));
+    void **space_keys = malloc(slots * sizeof(void*));
+    void **space_ptrs = malloc(slots * sizeof(void*));
+    bool ok = space_ids && space_keys && space_ptrs;
+    if (ok) {
+        // IDs are already in ascending order, so they bulk-load directly
+        for (int i = 0; i < table->count; ++i) {
+            space_ids[i] = i + 1;
+            space_keys[i] = &space_ids[i];
+            space_ptrs[i] = &table->spaces[i];
+        }
+        ok = bulkLoadBPlusTree(table->view, space_keys, space_ptrs, table->count, 1.0);
+    }
+    if (!ok) {
+        logError(" Failed to build the space tree view for %d spaces.\n", table->count);
+        destroyBPlusTree(table->view);
+        table->view = NULL;
+    }
+    free(space_ids);
+    free(space_keys);
+    free(space_ptrs);
+    return ok;
+}
+
+void destroySpaceTable(SpaceTable *table) {
+    if (!table) return;
+    destroyBPlusTree(table->view); // Safe even if NULL
+    free(table->spaces);
+    free(table->free_bits);
+    free(table->word_summary);
+    table->view = NULL;
+    table->spaces = NULL;
+    table->free_bits = NULL;
+    table->word_summary = NULL;
+    table->count = 0;
+    table->word_count = 0;
+}
+
+// Helper to find the lowest free space ID in [start_id, end_id]: checks the first word of the
+// range, then jumps to the next word with a free space through the summary bitmap.
+// O(range / 4096) worst case, one or two words in the common case.
+int findSpaceInRange(const SpaceTable *spaces, int start_id, int end_id) {
+    if (!spaces || !spaces->free_bits) return -1; // No table
+    if (start_id < 1) start_id = 1;
+    if (end_id > spaces->count) end_id = spaces->count;
+    if (start_id > end_id) return -1;
+    int first = start_id - 1, last = end_id - 1; // Bit positions
+    int w = first / 64, last_w = last / 64;
+    uint64_t word = spaces->free_bits[w] & (~0ULL << (first % 64));
+    if (!word) {
+        w = findNonEmptyWord(spaces, w + 1, last_w);
+        if (w < 0) return -1;
+        word = spaces->free_bits[w];
+    }
+    if (w == last_w && last % 64 != 63) word &= (1ULL << (last % 64 + 1)) - 1;
+    if (!word) return -1;
+    return w * 64 + __builtin_ctzll(word) + 1;
+}
+
+// First bitmap word index in [from_w, to_w] that has a free space, or -1
+int findNonEmptyWord(const SpaceTable *spaces, int from_w, int to_w) {
+    if (from_w > to_w) return -1;
+    for (int s = from_w / 64; s <= to_w / 64; s++) {
+        uint64_t summary = spaces->word_summary[s];
+        if (s == from_w / 64) summary &= ~0ULL << (from_w % 64);
+        if (summary) {
+            int w = s * 64 + __builtin_ctzll(summary);
+            return w <= to_w ? w : -1;
+        }
+    }
+    return -1;
+}
+
+
+int findAvailableSpace(const SpaceTable *spaces, MembershipType membership) {
+    int space_id = -1;
+    const LotConfig *lot = &spaces->layout;
+
+    // Try preferred range first
+    if (membership == GOLD) {
+        space_id = findSpaceInRange(spaces, lot->gold_first, lot->gold_last);
+        logDebug("Searching for GOLD space , Found: %d\n", space_id);
+    }
+    if (space_id == -1 && (membership == GOLD || membership == PREMIUM)) {
+         space_id = findSpaceInRange(spaces, lot->premium_first, lot->premium_last);
+         logDebug("Searching for PREMIUM space , Found: %d\n", space_id);
+    }
+    if (space_id == -1) {
+         space_id = findSpaceInRange(spaces, lot->general_first, lot->general_last);
+         logDebug("Searching for GENERAL space (%d-%d)... Found: %d\n", lot->general_first, lot->general_last, space_id);
+    }
+    return space_id;
+}
+
+// --- Amount Index ---
+// Secondary B+ tree over the vehicles ordered by (total_amount_paid descending, plate), the order
+// of the amount report. It lives in vehicleTree->amount_index, shares the Vehicle records (it has
+// no free_data) and is kept in step by vehicleEntry/vehicleExit. The loaders rebuild it when it
+// exists. A range report seeks to max_amount and walks the leaves until amounts drop below
+// min_amount, instead of sorting every vehicle.
+
+AmountKey makeAmountKey(const Vehicle *v) {
+    AmountKey key;
+    key.amount = isnan(v->total_amount_paid) ? -INFINITY : v->total_amount_paid + 0.0; // + 0.0 turns -0.0 into 0.0
+    key.plate = makePlateKey(v->vehicle_number);
+    return key;
+}
+
+// IEEE-754 bits made monotonic (negative values inverted, positive ones get the sign bit set),
+// then inverted so that larger amounts come first
+uint64_t amountOrderBits(double amount) {
+    uint64_t bits;
+    memcpy(&bits, &amount, sizeof(bits));
+    bits = (bits & 0x8000000000000000ULL) ? ~bits : bits | 0x8000000000000000ULL;
+    return ~bits;
+}
+
+// Stable LSD radix sort on amountOrderBits, one byte per pass, skipping passes where every
+// entry has the same byte. The result ends up in 'entries'.
+void radixSortAmountEntries(AmountIndexEntry *entries, AmountIndexEntry *scratch, int n) {
+    if (n < 2) return;
+    size_t (*counts)[256] = calloc(8, sizeof(*counts));
+    if (!counts) { // No histogram memory: the comparison sort gives the same order
+        qsort(entries, n, sizeof(AmountIndexEntry), compare_amount_keys);
+        return;
+    }
+    for (int i = 0; i < n; i++) {
+        uint64_t bits = amountOrderBits(entries[i].key.amount);
+        for (int b = 0; b < 8; b++) counts[b][(bits >> (8 * b)) & 0xFF]++;
+    }
+    AmountIndexEntry *src = entries, *dst = scratch;
+    for (int b = 0; b < 8; b++) {
+        if (counts[b][(amountOrderBits(src[0].key.amount) >> (8 * b)) & 0xFF] == (size_t)n) continue;
+        size_t offset = 0;
+        for (int d = 0; d < 256; d++) {
+            size_t c = counts[b][d];
+            counts[b][d] = offset;
+            offset += c;
+        }
+        for (int i = 0; i < n; i++) {
+            dst[counts[b][(amountOrderBits(src[i].key.amount) >> (8 * b)) & 0xFF]++] = src[i];
+        }
+        AmountIndexEntry *swap = src; src = dst; dst = swap;
+    }
+    if (src != entries) memcpy(entries, src, (size_t)n * sizeof(AmountIndexEntry));
+    free(counts);
+}
+
+// Bulk-loads a fresh index from the vehicle leaves, replacing any previous one. The leaves give
+// the entries in plate order and the stable sort by amount keeps that order for equal amounts,
+// so the keys come out strictly ascending.
+bool buildAmountIndex(BPlusTree *vehicleTree) {
+    if (!vehicleTree) return false;
+    destroyBPlusTree(vehicleTree->amount_index);
+    vehicleTree->amount_index = NULL;
+    BPlusTree *index = createBPlusTree(MIN_DEGREE, sizeof(AmountKey), compare_amount_keys, NULL, NULL);
+    if (!index) return false;
+
+    int n = 0;
+    for (BPlusTreeNode *leaf = vehicleTree->first_leaf; leaf; leaf = leaf->node_type.leaf.next) n += leaf->n;
+    AmountIndexEntry *entries = malloc((size_t)(n > 0 ? n : 1) * sizeof(AmountIndexEntry));
+    AmountIndexEntry *scratch = malloc((size_t)(n > 0 ? n : 1) * sizeof(AmountIndexEntry));
+    if (!entries || !scratch) {
+        logError(" Failed to allocate the amount index for %d vehicles.\n", n);
+        free(entries); free(scratch);
+        destroyBPlusTree(index);
+        return false;
+    }
+    int count = 0;
+    for (BPlusTreeNode *leaf = vehicleTree->first_leaf; leaf; leaf = leaf->node_type.leaf.next) {
+        for (int i = 0; i < leaf->n; i++) {
+            Vehicle *v = (Vehicle*)leaf->node_type.leaf.data_pointers[i];
+            entries[count].key = makeAmountKey(v);
+            entries[count].vehicle = v;
+            count++;
+        }
+    }
+    radixSortAmountEntries(entries, scratch, count);
+    // The scratch buffer is free again: reuse it for the key/data pointer arrays bulk loading takes
+    void **key_ptrs = (void**)scratch, **vehicles = (void**)scratch + count;
+    for (int i = 0; i < count; i++) {
+        key_ptrs[i] = &entries[i].key; // Copied into the nodes (no free_key)
+        vehicles[i] = entries[i].vehicle;
+    }
+    bool ok = bulkLoadBPlusTree(index, key_ptrs, vehicles, count, BULK_LOAD_FILL_FACTOR);
+    free(entries);
+    free(scratch);
+    if (!ok) {
+        destroyBPlusTree(index);
+        return false;
+    }
+    vehicleTree->amount_index = index;
+    vehicleTree->amount_entries = count;
+    reserveAmountIndexHeadroom(vehicleTree);
+    return true;
+}
+
+// An exit moves an entry within a fixed set, so the index never needs more nodes than the
+// worst-case shape for its entry count. Keeping that many slabs on hand (free or not yet carved)
+// means a move never grows the arena. Called after the entry count grows.
+bool reserveAmountIndexHeadroom(BPlusTree *vehicleTree) {
+    BPlusTree *index = vehicleTree->amount_index;
+    NodeArena *arena = &index->arena;
+    long shortfall = (long)bplusTreeMaxNodes(index->t, vehicleTree->amount_entries)
+                   - (long)arena->live_nodes - (long)nodeArenaSpareSlabs(arena);
+    if (shortfall <= 0) return true;
+    // The new chunk replaces the rest of the current one, and has some slack so registering
+    // vehicles one at a time does not reserve a chunk each time
+    int unused = arena->chunks ? arena->chunks->capacity - arena->chunks->used : 0;
+    if (!nodeArenaReserve(arena, unused + (int)shortfall + 64)) {
+        logWarn("Warning: Could not reserve %ld amount index nodes. Exits may allocate.\n", shortfall);
+        return false;
+    }
+    return true;
+}
+
+// Moves v from its old amount to its current one. If the old entry is missing the index has
+// drifted from the vehicles, so it is rebuilt rather than patched.
+bool updateAmountIndex(BPlusTree *vehicleTree, Vehicle *v, double old_amount) {
+    if (!vehicleTree || !vehicleTree->amount_index || !v) return true;
+    AmountKey key = makeAmountKey(v);
+    AmountKey old_key = key;
+    old_key.amount = isnan(old_amount) ? -INFINITY : old_amount;
+    if (old_key.amount == key.amount) return true;
+    if (!deleteBPlusTree(vehicleTree->amount_index, &old_key, NULL)) { // The index owns no data
+        logWarn("Warning: Amount index entry missing for %s. Rebuilding the index.\n", v->vehicle_number);
+        return buildAmountIndex(vehicleTree);
+    }
+    return insertAmountTree(vehicleTree->amount_index, key, v);
+}
+
+// Visits the index entries with min_amount <= amount <= max_amount, highest amount first (data is
+// the Vehicle*). NaN amounts are indexed as -INFINITY. Returns the number of entries visited.
+int scanAmountIndex(BPlusTree *vehicleTree, double min_amount, double max_amount, BPlusVisitor visit, void *ctx) {
+    if (!vehicleTree || !vehicleTree->amount_index) return 0;
+    AmountKey lo = {max_amount, {0, 0}};                  // Smallest plate: precedes every entry with this amount
+    AmountKey hi = {min_amount, {UINT64_MAX, UINT64_MAX}}; // Largest plate: follows every entry with this amount
+    return rangeScan(vehicleTree->amount_index, &lo, &hi, visit, ctx);
+}
+
+// --- Binary Snapshot ---
+
+// Encodes a 1-based index in a pointer slot of a stored node image
+void* snapshotIndexToSlot(int64_t index) {
+    return (void*)(uintptr_t)index;
+}
+
+int64_t snapshotSlotToIndex(const void *slot) {
+    return (int64_t)(uintptr_t)slot;
+}
+
+bool saveSnapshot(const char *path, BPlusTree *vehicleTree, const SpaceTable *spaces) {
+    if (!path || !vehicleTree || !spaces || !spaces->spaces) {
+        logError("Error: Invalid arguments for saveSnapshot.\n");
+        return false;
+    }
+    NodeArena *arena = &vehicleTree->arena;
+    int64_t node_count = (int64_t)arena->live_nodes;
+    BPlusTreeNode **order = malloc((size_t)(node_count > 0 ? node_count : 1) * sizeof(BPlusTreeNode*));
+    unsigned char *image = aligned_alloc(CACHE_LINE_SIZE, arena->slab_size);
+    char temp_path[1024];
+    snprintf(temp_path, sizeof(temp_path), "%s.tmp", path);
+    FILE *fp = fopen(temp_path, "wb");
+    if (!order || !image || !fp) {
+        logError("Error: Could not write snapshot '%s'.\n", path);
+        free(order); free(image);
+        if (fp) fclose(fp);
+        return false;
+    }
+
+    // Breadth-first node order; the tree is balanced, so the last level is the leaf list in order
+    int64_t queued = 0;
+    if (vehicleTree->root) order[queued++] = vehicleTree->root;
+    int64_t first_leaf_index = 0, vehicle_count = 0;
+    for (int64_t i = 0; i < queued; i++) {
+        BPlusTreeNode *node = order[i];
+        if (node->is_leaf) {
+            if (first_leaf_index == 0) first_leaf_index = i + 1;
+            vehicle_count += node->n;
+        } else {
+            for (int c = 0; c <= node->n && queued < node_count; c++) order[queued++] = node->node_type.internal.C[c];
+        }
+    }
+
+    SnapshotHeader header = {0};
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.byte_order = 0x01020304;
+    header.vehicle_size = sizeof(Vehicle);
+    header.space_size = sizeof(ParkingSpace);
+    header.node_size = sizeof(BPlusTreeNode);
+    header.slab_size = (uint32_t)arena->slab_size;
+    header.slab_offset = (uint32_t)arena->slab_offset;
+    header.key_block_size = (uint32_t)vehicleTree->key_block_size;
+    header.key_size = (uint32_t)vehicleTree->key_size;
+    header.min_degree = vehicleTree->t;
+    header.layout = spaces->layout;
+    header.space_count = spaces->count;
+    header.vehicle_count = vehicle_count;
+    header.node_count = queued;
+    header.root_index = queued > 0 ? 1 : 0;
+    header.first_leaf_index = first_leaf_index;
+    header.saved_at = (int64_t)time(NULL);
+    header.spaces_offset = roundUpToCacheLine(sizeof(SnapshotHeader));
+    header.vehicles_offset = roundUpToCacheLine(header.spaces_offset + (uint64_t)spaces->count * sizeof(ParkingSpace));
+    header.nodes_offset = roundUpToCacheLine(header.vehicles_offset + (uint64_t)vehicle_count * sizeof(Vehicle));
+    header.file_size = header.nodes_offset + (uint64_t)queued * arena->slab_size;
+
+    static const unsigned char padding[CACHE_LINE_SIZE] = {0};
+    bool ok = fwrite(&header, sizeof(header), 1, fp) == 1;
+    ok = ok && fwrite(padding, 1, header.spaces_offset - sizeof(header), fp) == header.spaces_offset - sizeof(header);
+    ok = ok && fwrite(spaces->spaces, sizeof(ParkingSpace), (size_t)spaces->count, fp) == (size_t)spaces->count;
+    uint64_t written = header.spaces_offset + (uint64_t)spaces->count * sizeof(ParkingSpace);
+    ok = ok && fwrite(padding, 1, header.vehicles_offset - written, fp) == header.vehicles_offset - written;
+    for (BPlusTreeNode *leaf = vehicleTree->first_leaf; ok && leaf; leaf = leaf->node_type.leaf.next) {
+        for (int i = 0; ok && i < leaf->n; i++) {
+            ok = fwrite(leaf->node_type.leaf.data_pointers[i], sizeof(Vehicle), 1, fp) == 1;
+        }
+    }
+    written = header.vehicles_offset + (uint64_t)vehicle_count * sizeof(Vehicle);
+    ok = ok && fwrite(padding, 1, header.nodes_offset - written, fp) == header.nodes_offset - written;
+
+    // Node images: children are numbered in the same breadth-first order used above
+    int64_t next_child = 2, vehicle_index = 1;
+    for (int64_t i = 0; ok && i < queued; i++) {
+        BPlusTreeNode *node = order[i];
+        memcpy(image, node, arena->slab_size);
+        BPlusTreeNode *copy = (BPlusTreeNode*)image;
+        void **pointers = (void**)(image + arena->slab_offset + vehicleTree->key_block_size);
+        copy->keys = NULL;
+        copy->tree = NULL;
+        if (node->is_leaf) {
+            copy->node_type.leaf.data_pointers = NULL;
+            for (int j = 0; j < node->n; j++) pointers[j] = snapshotIndexToSlot(vehicle_index++);
+            copy->node_type.leaf.prev = snapshotIndexToSlot(node->node_type.leaf.prev ? i : 0); // i is this node's index - 1
+            copy->node_type.leaf.next = snapshotIndexToSlot(node->node_type.leaf.next ? i + 2 : 0);
+        } else {
+            copy->node_type.internal.C = NULL;
+            for (int j = 0; j <= node->n; j++) pointers[j] = snapshotIndexToSlot(next_child++);
+        }
+        ok = fwrite(image, arena->slab_size, 1, fp) == 1;
+    }
+    ok = (fclose(fp) == 0) && ok;
+    free(order);
+    free(image);
+    if (!ok || rename(temp_path, path) != 0) {
+        logError("Error: Could not write snapshot '%s'.\n", path);
+        remove(temp_path);
+        return false;
+    }
+    logInfo("Snapshot saved to %s: %lld vehicles, %lld spaces, %lld tree nodes.\n", path,
+            (long long)vehicle_count, (long long)spaces->count, (long long)queued);
+    return true;
+}
+
+// Node image for a 1-based stored index
+const unsigned char* snapshotNodeImage(const MappedFile *file, const SnapshotHeader *h, int64_t index) {
+    return (const unsigned char*)file->data + h->nodes_offset + (uint64_t)(index - 1) * h->slab_size;
+}
+
+// Reads is_leaf as a raw byte: a damaged image can hold any value there, which is not a valid bool
+int snapshotNodeKind(const MappedFile *file, const SnapshotHeader *h, int64_t index) {
+    unsigned char kind;
+    memcpy(&kind, snapshotNodeImage(file, h, index) + offsetof(BPlusTreeNode, is_leaf), 1);
+    return kind;
+}
+
+// Checks that a snapshot was written by a build with this layout and that every section and
+// stored index is in range, so restoring it cannot read or point outside the file. The node links
+// must also form one balanced tree rooted at node 1 (children are stored after their parent and
+// referenced once, every leaf at the same depth, leaves stored last as one chain) whose leaves own
+// each stored vehicle exactly once, so the restored tree cannot loop or free a vehicle twice.
+bool validateSnapshot(const MappedFile *file, const SnapshotHeader *h, const BPlusTree *tree) {
+    if (h->version != SNAPSHOT_VERSION || h->byte_order != 0x01020304) return false;
+    if (h->vehicle_size != sizeof(Vehicle) || h->space_size != sizeof(ParkingSpace) ||
+        h->node_size != sizeof(BPlusTreeNode) || h->slab_size != tree->arena.slab_size ||
+        h->slab_offset != tree->arena.slab_offset || h->key_block_size != tree->key_block_size ||
+        h->key_size != tree->key_size || h->min_degree != tree->t) return false;
+    if (h->file_size != file->size || h->space_count < 1 || h->space_count > MAX_LOT_SIZE ||
+        h->layout.lot_size != h->space_count || h->vehicle_count < 0 || h->node_count < 0 ||
+        h->node_count > (int64_t)INT32_MAX || h->root_index > h->node_count || h->first_leaf_index > h->node_count ||
+        (h->node_count > 0 && (h->root_index != 1 || h->first_leaf_index < 1)) ||
+        (h->node_count == 0 && h->vehicle_count > 0)) return false;
+    if (h->spaces_offset < sizeof(SnapshotHeader) ||
+        h->vehicles_offset < h->spaces_offset + (uint64_t)h->space_count * sizeof(ParkingSpace) ||
+        h->nodes_offset < h->vehicles_offset + (uint64_t)h->vehicle_count * sizeof(Vehicle) ||
+        h->file_size != h->nodes_offset + (uint64_t)h->node_count * h->slab_size) return false;
+    const ParkingSpace *stored_spaces = (const ParkingSpace*)(file->data + h->spaces_offset);
+    for (int64_t i = 0; i < h->space_count; i++) {
+        if (stored_spaces[i].space_id != i + 1) return false; // Spaces are stored by ID
+    }
+    const Vehicle *stored_vehicles = (const Vehicle*)(file->data + h->vehicles_offset);
+    for (int64_t i = 0; i < h->vehicle_count; i++) {
+        const Vehicle *v = &stored_vehicles[i];
+        if ((unsigned)v->membership > GOLD) return false; // Indexes membership_strings
+        if (v->current_parking_space_id != -1 &&
+            (v->current_parking_space_id < 1 || v->current_parking_space_id > h->space_count)) return false;
+    }
+    if (h->node_count == 0) return true;
+
+    // depth[i] = depth of node i + 1 (root = 1, 0 = not reached yet); owned[v] marks claimed vehicles
+    unsigned char *depth = calloc((size_t)h->node_count, 1);
+    unsigned char *owned = calloc((size_t)(h->vehicle_count > 0 ? h->vehicle_count : 1), 1);
+    bool ok = depth && owned;
+    int max_keys = 2 * tree->t - 1, leaf_depth = 0;
+    int64_t vehicles_seen = 0;
+    if (ok) depth[0] = 1;
+    for (int64_t i = 1; ok && i <= h->node_count; i++) {
+        const unsigned char *image = snapshotNodeImage(file, h, i);
+        const BPlusTreeNode *node = (const BPlusTreeNode*)image;
+        void * const *pointers = (void * const*)(image + h->slab_offset + h->key_block_size);
+        int kind = snapshotNodeKind(file, h, i);
+        // Children come after their parent, so every node's depth is known when it is reached here
+        if (kind > 1 || depth[i - 1] == 0 || node->n < 0 || node->n > max_keys) { ok = false; break; }
+        if (kind == 1) {
+            // Leaves are stored last and in key order, so each one links to its stored neighbours
+            if (leaf_depth == 0) leaf_depth = depth[i - 1];
+            int64_t prev = snapshotSlotToIndex(node->node_type.leaf.prev), next = snapshotSlotToIndex(node->node_type.leaf.next);
+            ok = depth[i - 1] == leaf_depth && prev == (i == h->first_leaf_index ? 0 : i - 1) &&
+                 next == (i == h->node_count ? 0 : i + 1);
+            for (int j = 0; ok && j < node->n; j++) {
+                int64_t index = snapshotSlotToIndex(pointers[j]);
+                ok = index >= 1 && index <= h->vehicle_count && !owned[index - 1];
+                if (ok) owned[index - 1] = 1;
+            }
+            vehicles_seen += node->n;
+        } else {
+            ok = leaf_depth == 0; // Internal nodes all come before the first leaf
+            for (int j = 0; ok && j <= node->n; j++) {
+                int64_t index = snapshotSlotToIndex(pointers[j]);
+                ok = index > i && index <= h->node_count && depth[index - 1] == 0 && depth[i - 1] < BPT_MAX_HEIGHT;
+                if (ok) depth[index - 1] = depth[i - 1] + 1;
+            }
+        }
+    }
+    ok = ok && vehicles_seen == h->vehicle_count && snapshotNodeKind(file, h, h->first_leaf_index) == 1 &&
+         (h->first_leaf_index == 1 || snapshotNodeKind(file, h, h->first_leaf_index - 1) == 0);
+    free(depth);
+    free(owned);
+    return ok;
+}
+
+bool loadSnapshot(const char *path, BPlusTree *vehicleTree, SpaceTable *spaces) {
+    if (!path || !vehicleTree || !spaces) return false;
+    if (vehicleTree->root && (!vehicleTree->root->is_leaf || vehicleTree->root->n > 0)) {
+        logError("Error: loadSnapshot requires an empty vehicle tree.\n");
+        return false;
+    }
+    MappedFile file;
+    if (!mapInputFile(path, &file)) return false; // No snapshot yet
+    SnapshotHeader header;
+    if (file.size < sizeof(header) || memcmp(file.data, SNAPSHOT_MAGIC, 8) != 0) {
+        logWarn("Warning: '%s' is not a parking snapshot. Ignored.\n", path);
+        unmapInputFile(&file);
+        return false;
+    }
+    memcpy(&header, file.data, sizeof(header));
+    if (!validateSnapshot(&file, &header, vehicleTree)) {
+        logWarn("Warning: Snapshot '%s' (version %u) does not match this build or is damaged. Ignored.\n", path, header.version);
+        unmapInputFile(&file);
+        return false;
+    }
+
+    // Everything that can fail is allocated before the live table or tree is touched, so a snapshot
+    // that cannot be restored leaves both exactly as they were for the file.txt fallback.
+    // Spaces: build a table for the stored lot, then copy the records and re-derive the bitmaps
+    SpaceTable restored;
+    if (!initSpaceTable(&restored, &header.layout)) {
+        unmapInputFile(&file);
+        return false;
+    }
+    memcpy(restored.spaces, file.data + header.spaces_offset, (size_t)header.space_count * sizeof(ParkingSpace));
+    for (int i = 0; i < restored.count; i++) {
+        ParkingSpace *ps = &restored.spaces[i];
+        ps->parked_vehicle_num[sizeof(ps->parked_vehicle_num) - 1] = '\0';
+        if (ps->status != 0) setSpaceStatus(&restored, ps, 1);
+    }
+    bool ok = !spaces->view || buildSpaceTreeView(&restored);
+
+    // Vehicles: one allocation each, since the tree frees them one at a time
+    const Vehicle *stored_vehicles = (const Vehicle*)(file.data + header.vehicles_offset);
+    Vehicle **vehicles = malloc((size_t)(header.vehicle_count > 0 ? header.vehicle_count : 1) * sizeof(Vehicle*));
+    BPlusTreeNode **nodes = malloc((size_t)(header.node_count > 0 ? header.node_count : 1) * sizeof(BPlusTreeNode*));
+    ok = ok && vehicles && nodes;
+    int64_t made = 0;
+    for (; ok && made < header.vehicle_count; made++) {
+        vehicles[made] = malloc(sizeof(Vehicle));
+        if (!vehicles[made]) break;
+        memcpy(vehicles[made], &stored_vehicles[made], sizeof(Vehicle));
+        vehicles[made]->vehicle_number[sizeof(vehicles[made]->vehicle_number) - 1] = '\0'; // Never trust stored strings
+        vehicles[made]->owner_name[sizeof(vehicles[made]->owner_name) - 1] = '\0';
+    }
+    ok = ok && made == header.vehicle_count && nodeArenaReserve(&vehicleTree->arena, (int)header.node_count);
+    if (!ok) {
+        logError(" Failed to allocate memory to restore snapshot '%s'.\n", path);
+        for (int64_t i = 0; vehicles && i < made; i++) free(vehicles[i]);
+        free(vehicles); free(nodes);
+        destroySpaceTable(&restored);
+        unmapInputFile(&file);
+        return false;
+    }
+
+    // Nothing below can fail: swap in the restored spaces
+    destroySpaceTable(spaces);
+    *spaces = restored;
+
+    // Tree: copy the slab images into the arena, then turn the stored indexes back into pointers
+    if (header.node_count > 0) {
+        releaseBPlusTreeNode(vehicleTree->root); // Discard the empty root leaf
+        for (int64_t i = 0; i < header.node_count; i++) {
+            nodes[i] = nodeArenaAlloc(&vehicleTree->arena); // Reserved above, cannot fail
+            memcpy(nodes[i], file.data + header.nodes_offset + (uint64_t)i * header.slab_size, header.slab_size);
+        }
+        for (int64_t i = 0; i < header.node_count; i++) {
+            BPlusTreeNode *node = nodes[i];
+            node->tree = vehicleTree;
+            node->keys = (unsigned char*)node + vehicleTree->arena.slab_offset;
+            void **pointers = (void**)(node->keys + vehicleTree->key_block_size);
+            if (node->is_leaf) {
+                node->node_type.leaf.data_pointers = pointers;
+                for (int j = 0; j < node->n; j++) pointers[j] = vehicles[snapshotSlotToIndex(pointers[j]) - 1];
+                int64_t prev = snapshotSlotToIndex(node->node_type.leaf.prev), next = snapshotSlotToIndex(node->node_type.leaf.next);
+                node->node_type.leaf.prev = prev ? nodes[prev - 1] : NULL;
+                node->node_type.leaf.next = next ? nodes[next - 1] : NULL;
+            } else {
+                node->node_type.internal.C = (BPlusTreeNode**)pointers;
+                for (int j = 0; j <= node->n; j++) pointers[j] = nodes[snapshotSlotToIndex(pointers[j]) - 1];
+            }
+        }
+        vehicleTree->root = nodes[header.root_index - 1];
+        vehicleTree->first_leaf = nodes[header.first_leaf_index - 1];
+    }
+    free(vehicles);
+    free(nodes);
+    unmapInputFile(&file);
+    if (vehicleTree->amount_index) buildAmountIndex(vehicleTree); // Not stored in the snapshot
+
+    char time_buf[30];
+    formatTime((time_t)header.saved_at, time_buf, sizeof(time_buf));
+    logInfo("Restored snapshot %s (saved %s): %lld vehicles, %d spaces.\n", path, time_buf,
+            (long long)header.vehicle_count, spaces->count);
+    return true;
+}
+
+// --- Gate Operations (library API) ---
+// Entry, exit and occupancy queries with explicit arguments and result structs: nothing here reads
+// stdin or formats a message for the operator. The only output is the diagnostic log in outputFile
+// (space search trace, consistency errors), so callers that need no log can point it at /dev/null.
+
+// Parks vehicle_num at arrival_time. A vehicle seen for the first time is registered with
+// owner_name (NULL = "Unknown") and parked under the non-member policy.
+EntryResult vehicleEntry(BPlusTree *vehicleTree, SpaceTable *spaces, const char *vehicle_num,
+                         const char *owner_name, time_t arrival_time) {
+    EntryResult result = {PARK_ERROR, false, -1, arrival_time, NULL};
+    if (!vehicleTree || !spaces || !vehicle_num || !vehicle_num[0]) return result;
+
+    Vehicle *v = lookupVehicle(vehicleTree, vehicle_num);
+    result.new_vehicle = (v == NULL);
+    result.vehicle = v;
+    if (v && v->current_parking_space_id != -1) {
+        result.status = PARK_ALREADY_PARKED;
+        result.space_id = v->current_parking_space_id;
+        return result;
+    }
+
+    // New vehicles get non-member allocation policy
+    int space_id = findAvailableSpace(spaces, v ? v->membership : NO_MEMBERSHIP);
+    result.space_id = space_id;
+    if (space_id == -1) {
+        result.status = PARK_LOT_FULL;
+        return result;
+    }
+    ParkingSpace *ps = lookupSpace(spaces, space_id);
+    if (!ps || ps->status != 0) return result; // Bitmap and table disagree
+
+    if (!v) {
+        v = (Vehicle*)calloc(1, sizeof(Vehicle));
+        if (!v) {
+        //    perror(" Failed to allocate memory for new vehicle struct");
+            logError(" Failed to allocate memory for new vehicle struct %s.\n", vehicle_num);
+            return result;
+        }
+        safe_strcpy(v->vehicle_number, vehicle_num, sizeof(v->vehicle_number));
+        safe_strcpy(v->owner_name, owner_name && owner_name[0] ? owner_name : "Unknown", sizeof(v->owner_name));
+        v->membership = NO_MEMBERSHIP;
+        v->total_parking_hours = 0.0;
+        v->num_parkings = 0; // Will be incremented on first exit
+        v->total_amount_paid = 0.0;
+        v->current_parking_space_id = -1;
+        // Key is a plain value, copied into the node; the tree owns v from here (frees it on failure)
+        if (!insertPlateTree(vehicleTree, makePlateKey(v->vehicle_number), v)) return result;
+        if (vehicleTree->amount_index && insertAmountTree(vehicleTree->amount_index, makeAmountKey(v), v)) {
+            vehicleTree->amount_entries++;
+            reserveAmountIndexHeadroom(vehicleTree);
+        }
+        result.vehicle = v;
+    }
+
+    setSpaceStatus(spaces, ps, 1); // Occupy space
+    safe_strcpy(ps->parked_vehicle_num, v->vehicle_number, sizeof(ps->parked_vehicle_num));
+    v->current_parking_space_id = space_id;
+    v->arrival_time = arrival_time;
+    v->last_departure_time = 0; // Clear last departure time
+    result.status = PARK_OK;
+    return result;
+}
+
+// Departs vehicle_num at departure_time: charges the fee, updates membership and frees the space
+ExitResult vehicleExit(BPlusTree *vehicleTree, SpaceTable *spaces, const char *vehicle_num, time_t departure_time) {
+    ExitResult result = {PARK_ERROR, -1, 0, departure_time, 0.0, 0.0, NO_MEMBERSHIP, NO_MEMBERSHIP, NULL};
+    if (!vehicleTree || !spaces || !vehicle_num) return result;
+
+    Vehicle *v = lookupVehicle(vehicleTree, vehicle_num);
+    result.vehicle = v;
+    if (!v) {
+        result.status = PARK_NOT_FOUND;
+        return result;
+    }
+    if (v->current_parking_space_id == -1 || v->arrival_time == 0) {
+        result.status = PARK_NOT_PARKED;
+        return result;
+    }
+
+    result.arrival_time = v->arrival_time;
+    double duration_seconds = difftime(departure_time, v->arrival_time);
+    if (duration_seconds < 0) duration_seconds = 0; // Handle clock skew
+
+    result.duration_hours = duration_seconds / 3600.0;
+    result.old_membership = v->membership;
+    v->total_parking_hours += result.duration_hours;
+    v->num_parkings++;
+    v->last_departure_time = departure_time;
+
+    updateMembership(v); // Update membership based on new total hours
+    result.membership = v->membership;
+
+    result.fee = calculateParkingFee(result.duration_hours, v->membership);
+    double old_amount = v->total_amount_paid;
+    v->total_amount_paid += result.fee;
+    updateAmountIndex(vehicleTree, v, old_amount);
+
+    result.space_id = v->current_parking_space_id;
+    // Update vehicle state *before* updating space
+    v->current_parking_space_id = -1;
+    v->arrival_time = 0; // Mark as not parked
+
+    // Update Parking Space
+    ParkingSpace *ps = lookupSpace(spaces, result.space_id);
+    if (ps) {
+        setSpaceStatus(spaces, ps, 0); // Free the space
+        ps->occupancy_count++;
+        ps->total_revenue += result.fee;
+        safe_strcpy(ps->parked_vehicle_num, "", sizeof(ps->parked_vehicle_num)); // Clear parked vehicle
+    } else {
+    //    fprintf(stderr, "CRITICAL Error: Parking space %d data not found for exiting vehicle %s!\n", space_id, vehicle_num);
+        logError("CRITICAL Error: Space %d data missing during exit of %s!\n", result.space_id, vehicle_num);
+    }
+    result.status = PARK_OK;
+    return result;
+}
+
+// Free spaces with IDs in [first_id, last_id], counted from the free bitmap
+int countFreeSpaces(const SpaceTable *spaces, int first_id, int last_id) {
+    if (first_id < 1) first_id = 1;
+    if (last_id > spaces->count) last_id = spaces->count;
+    int free_count = 0;
+    for (int id = first_id; id <= last_id; ) {
+        int bit = (id - 1) & 63;
+        int take = 64 - bit;
+        if (take > last_id - id + 1) take = last_id - id + 1;
+        uint64_t mask = (take == 64 ? ~0ULL : ((1ULL << take) - 1)) << bit;
+        free_count += __builtin_popcountll(spaces->free_bits[(id - 1) >> 6] & mask);
+        id += take;
+    }
+    return free_count;
+}
+
+// Lot-wide and per-tier availability
+OccupancyResult queryOccupancy(const SpaceTable *spaces) {
+    OccupancyResult result = {0};
+    if (!spaces || !spaces->spaces) return result;
+    const LotConfig *lot = &spaces->layout;
+    result.total = spaces->count;
+    result.free = countFreeSpaces(spaces, 1, spaces->count);
+    result.occupied = result.total - result.free;
+    result.gold_free = countFreeSpaces(spaces, lot->gold_first, lot->gold_last);
+    result.premium_free = countFreeSpaces(spaces, lot->premium_first, lot->premium_last);
+    result.general_free = countFreeSpaces(spaces, lot->general_first, lot->general_last);
+    return result;
+}
+
+
+double calculateParkingFee(double hours, MembershipType membership) {
+    if (hours < 0) hours = 0; 
+    double fee;
+    if (hours <= 3.0) {
+        fee = 100.0;
+    } else {
+        double extra_hours = hours - 3.0;
+        // Charge 50 for each hour or part thereof using ceil
+        fee = 100.0 + ceil(extra_hours) * 50.0;
+    }
+    if (membership == PREMIUM || membership == GOLD) {
+        fee *= 0.90; // 10% discount
+    }
+    return fee;
+}
+
+
+// --- Vehicle Archival ---
+
+time_t vehicleLastActivity(const Vehicle *v) {
+    return v->last_departure_time > v->arrival_time ? v->last_departure_time : v->arrival_time;
+}
+
+// A vehicle with no recorded times has no idle period to measure and is never archived
+bool vehicleIsInactive(const Vehicle *v, time_t now, time_t max_idle) {
+    if (!v || max_idle <= 0 || v->current_parking_space_id != -1) return false;
+    time_t last_activity = vehicleLastActivity(v);
+    return last_activity > 0 && now - last_activity >= max_idle;
+}
+
+bool writeArchiveRecord(FILE *archive, const Vehicle *v, time_t archived_at) {
+    char arrival_buf[30], departure_buf[30], archived_buf[30];
+    formatTime(v->arrival_time, arrival_buf, sizeof(arrival_buf));
+    formatTime(v->last_departure_time, departure_buf, sizeof(departure_buf));
+    formatTime(archived_at, archived_buf, sizeof(archived_buf));
+    return fprintf(archive, "%s\t%s\t%s\t%s\t%s\t%d\t%.2f\t%.2f\t%s\n",
+                   v->vehicle_number, v->owner_name, membership_strings[v->membership],
+                   arrival_buf, departure_buf, v->num_parkings,
+                   v->total_parking_hours, v->total_amount_paid, archived_buf) > 0;
+}
+
+// Writes every inactive vehicle to archive (NULL = drop them) and deletes it from the tree, which
+// frees it through free_data. The amount index loses the same entries. Victims are collected first,
+// because deleting under a cursor would invalidate it. Returns the number of vehicles evicted.
+int archiveInactiveVehicles(BPlusTree *vehicleTree, time_t now, time_t max_idle, FILE *archive) {
+    if (!vehicleTree || max_idle <= 0) return 0;
+    Vehicle **victims = NULL;
+    int count = 0, capacity = 0;
+    BPlusCursor cursor;
+    for (cursorFirst(&cursor, vehicleTree); cursorValid(&cursor); cursorNext(&cursor)) {
+        Vehicle *v = (Vehicle*)cursorData(&cursor);
+        if (!vehicleIsInactive(v, now, max_idle)) continue;
+        if (count == capacity) {
+            int new_capacity = capacity ? capacity * 2 : 64;
+            Vehicle **grown = (Vehicle**)realloc(victims, new_capacity * sizeof(Vehicle*));
+            if (!grown) {
+                logError(" Failed to allocate the archival victim list.\n");
+                free(victims);
+                return -1;
+            }
+            victims = grown;
+            capacity = new_capacity;
+        }
+        victims[count++] = v;
+    }
+
+    int evicted = 0;
+    bool index_in_sync = true;
+    for (int i = 0; i < count; i++) {
+        Vehicle *v = victims[i];
+        if (archive && !writeArchiveRecord(archive, v, now)) {
+            logError("Error: Could not write vehicle %s to the archive. Archival stopped.\n", v->vehicle_number);
+            break;
+        }
+        AmountKey amount_key = makeAmountKey(v);
+        if (vehicleTree->amount_index) {
+            if (deleteBPlusTree(vehicleTree->amount_index, &amount_key, NULL)) vehicleTree->amount_entries--;
+            else index_in_sync = false;
+        }
+        PlateKey key = makePlateKey(v->vehicle_number);
+        if (deleteBPlusTree(vehicleTree, &key, NULL)) evicted++; // Releases v
+        else index_in_sync = false;
+    }
+    free(victims);
+    if (vehicleTree->amount_index && !index_in_sync) {
+        logWarn("Warning: Amount index out of step with the archived vehicles. Rebuilding the index.\n");
+        buildAmountIndex(vehicleTree);
+    }
+    return evicted;
+}
+
+// Runs a sweep at most once per sweep_interval of clock time. A clock with no time yet (an EVENT
+// clock before its first event) never sweeps.
+int runArchivePolicy(ArchivePolicy *policy, BPlusTree *vehicleTree, time_t now) {
+    if (!policy || policy->max_idle <= 0 || now <= 0) return 0;
+    if (policy->last_sweep && now - policy->last_sweep < policy->sweep_interval) return 0;
+    policy->last_sweep = now;
+    const char *path = policy->path ? policy->path : ARCHIVE_FILENAME;
+    FILE *archive = fopen(path, "a");
+    if (!archive) {
+        logError("Error: Could not open archive file '%s'. Inactive vehicles kept.\n", path);
+        return 0;
+    }
+    if (fseek(archive, 0, SEEK_END) == 0 && ftell(archive) == 0) fputs(ARCHIVE_HEADER, archive);
+    int evicted = archiveInactiveVehicles(vehicleTree, now, policy->max_idle, archive);
+    if (fclose(archive) != 0) logError("Error: Could not finish writing archive file '%s'.\n", path);
+    if (evicted > 0) {
+        logInfo("Archived %d vehicles inactive for %ld s or more to %s.\n", evicted, (long)policy->max_idle, path);
+    }
+    return evicted > 0 ? evicted : 0;
+}
+
+// --- Report Sorting ---
+// Reports copy each record's key into a ReportSortEntry array and sort that once: integer counts
+// with a stable LSD radix sort, doubles with an introsort whose comparison ends in the leaf
+// position. Both give exactly the order of the old insertion-sorted lists (descending key, ties
+// in leaf order) in O(n log n) or better, with two allocations per report instead of n.
+
+uint32_t reportCountRank(int count) {
+    return ~((uint32_t)count ^ 0x80000000u); // Flip the sign bit for unsigned order, then invert for descending
+}
+
+// Stable LSD radix sort on rank, one byte per pass. Passes where every entry has the same byte
+// (the high bytes of small counts) are skipped. The result ends up in 'entries'.
+void radixSortReportEntries(ReportSortEntry *entries, ReportSortEntry *scratch, int n) {
+    if (n < 2) return;
+    size_t counts[4][256] = {{0}};
+    for (int i = 0; i < n; i++) {
+        uint32_t rank = entries[i].rank;
+        for (int b = 0; b < 4; b++) counts[b][(rank >> (8 * b)) & 0xFF]++;
+    }
+    ReportSortEntry *src = entries, *dst = scratch;
+    for (int b = 0; b < 4; b++) {
+        if (counts[b][(src[0].rank >> (8 * b)) & 0xFF] == (size_t)n) continue; // All in one bucket
+        size_t offset = 0;
+        for (int d = 0; d < 256; d++) {
+            size_t c = counts[b][d];
+            counts[b][d] = offset;
+            offset += c;
+        }
+        for (int i = 0; i < n; i++) dst[counts[b][(src[i].rank >> (8 * b)) & 0xFF]++] = src[i];
+        ReportSortEntry *swap = src; src = dst; dst = swap;
+    }
+    if (src != entries) memcpy(entries, src, (size_t)n * sizeof(ReportSortEntry));
+}
+
+// Report order for amounts: larger first, NaN after every number, then leaf position. Positions
+// are unique, so this is a strict total order and the unstable sort still has one result.
+bool reportEntryBefore(const ReportSortEntry *a, const ReportSortEntry *b) {
+    if (a->amount > b->amount) return true;
+    if (a->amount < b->amount) return false;
+    bool a_nan = isnan(a->amount), b_nan = isnan(b->amount);
+    if (a_nan != b_nan) return b_nan;
+    return a->position < b->position;
+}
+
+void swapReportEntries(ReportSortEntry *a, ReportSortEntry *b) {
+    ReportSortEntry tmp = *a; *a = *b; *b = tmp;
+}
+
+// Heapsort fallback for ranges where quicksort partitioning degrades
+void heapSortReportEntries(ReportSortEntry *entries, int n) {
+    for (int start = n / 2 - 1, end = n; end > 1; ) {
+        int root;
+        if (start >= 0) {
+            root = start--; // Heapify phase
+        } else {
+            swapReportEntries(&entries[0], &entries[--end]); // Move the current last element into place
+            root = 0;
+        }
+        for (int child; (child = 2 * root + 1) < end; root = child) {
+            if (child + 1 < end && reportEntryBefore(&entries[child], &entries[child + 1])) child++;
+            if (!reportEntryBefore(&entries[root], &entries[child])) break;
+            swapReportEntries(&entries[root], &entries[child]);
+        }
+    }
+}
+
+#define INTROSORT_INSERTION_THRESHOLD 16
+
+// Quicksort (median-of-three, Hoare partition) down to small ranges, heapsort once the depth
+// budget runs out. Ranges of INTROSORT_INSERTION_THRESHOLD or fewer are left for the final pass.
+void introSortReportRange(ReportSortEntry *entries, int lo, int hi, int depth) {
+    while (hi - lo > INTROSORT_INSERTION_THRESHOLD) {
+        if (depth-- == 0) {
+            heapSortReportEntries(entries + lo, hi - lo);
+            return;
+        }
+        int mid = lo + (hi - lo) / 2;
+        if (reportEntryBefore(&entries[mid], &entries[lo])) swapReportEntries(&entries[mid], &entries[lo]);
+        if (reportEntryBefore(&entries[hi - 1], &entries[mid])) {
+            swapReportEntries(&entries[hi - 1], &entries[mid]);
+            if (reportEntryBefore(&entries[mid], &entries[lo])) swapReportEntries(&entries[mid], &entries[lo]);
+        }
+        ReportSortEntry pivot = entries[mid];
+        int i = lo - 1, j = hi;
+        for (;;) {
+            do i++; while (reportEntryBefore(&entries[i], &pivot));
+            do j--; while (reportEntryBefore(&pivot, &entries[j]));
+            if (i >= j) break;
+            swapReportEntries(&entries[i], &entries[j]);
+        }
+        // [lo, j] and [j + 1, hi): recurse into the smaller side, loop on the larger
+        if (j + 1 - lo < hi - j - 1) {
+            introSortReportRange(entries, lo, j + 1, depth);
+            lo = j + 1;
+        } else {
+            introSortReportRange(entries, j + 1, hi, depth);
+            hi = j + 1;
+        }
+    }
+}
+
+void introSortReportEntries(ReportSortEntry *entries, int n) {
+    if (n < 2) return;
+    int depth = 0;
+    for (int m = n; m > 1; m >>= 1) depth += 2; // 2 * log2(n)
+    introSortReportRange(entries, 0, n, depth);
+    // Final insertion sort: every element is at most one small range away from its place
+    for (int i = 1; i < n; i++) {
+        ReportSortEntry e = entries[i];
+        int j = i;
+        while (j > 0 && reportEntryBefore(&e, &entries[j - 1])) {
+            entries[j] = entries[j - 1];
+            j--;
+        }
+        entries[j] = e;
+    }
+}
+
+bool sortReportEntries(ReportSortEntry *entries, int n, int sortType) {
+    if (sortType == 1) {
+        ReportSortEntry *scratch = malloc((size_t)(n > 0 ? n : 1) * sizeof(ReportSortEntry));
+        if (!scratch) return false;
+        radixSortReportEntries(entries, scratch, n);
+        free(scratch);
+    } else if (sortType == 2) {
+        introSortReportEntries(entries, n);
+    }
+    return true;
+}
+
+// Collects every vehicle in leaf order and sorts the report (see VehicleReport)
+bool buildVehicleReport(BPlusTree *tree, int sortType, VehicleReport *report) {
+    report->vehicles = NULL;
+    report->count = 0;
+    if (!tree || !tree->first_leaf) return true;
+    int n = 0;
+    for (BPlusTreeNode *leaf = tree->first_leaf; leaf; leaf = leaf->node_type.leaf.next) {
+        if (leaf->is_leaf && leaf->node_type.leaf.data_pointers) n += leaf->n;
+    }
+    ReportSortEntry *entries = malloc((size_t)(n > 0 ? n : 1) * sizeof(ReportSortEntry));
+    if (!entries) {
+        logError(" Failed to allocate %d report entries.\n", n);
+        return false;
+    }
+    int count = 0;
+    for (BPlusTreeNode *leaf = tree->first_leaf; leaf; leaf = leaf->node_type.leaf.next) {
+        if (!leaf->is_leaf || !leaf->node_type.leaf.data_pointers) {
+            logError("Error: Corrupted leaf node during vehicle collection.\n");
+            continue;
+        }
+        for (int i = 0; i < leaf->n && count < n; i++) {
+            Vehicle *v = (Vehicle*)leaf->node_type.leaf.data_pointers[i];
+            if (!v) continue;
+            entries[count] = (ReportSortEntry){v, v->total_amount_paid, reportCountRank(v->num_parkings), count};
+            count++;
+        }
+    }
+    Vehicle **vehicles = malloc((size_t)(count > 0 ? count : 1) * sizeof(Vehicle*));
+    if (!vehicles || !sortReportEntries(entries, count, sortType)) {
+        logError(" Failed to allocate a report of %d vehicles.\n", count);
+        free(vehicles); free(entries);
+        return false;
+    }
+    for (int i = 0; i < count; i++) vehicles[i] = (Vehicle*)entries[i].item;
+    free(entries);
+    report->vehicles = vehicles;
+    report->count = count;
+    return true;
+}
+
+// The table is already in space_id order (the view's leaf order), so it is read directly
+bool buildSpaceReport(const SpaceTable *table, int sortType, SpaceReport *report) {
+    report->spaces = NULL;
+    report->count = 0;
+    if (!table || !table->spaces) return true;
+    int n = table->count;
+    ReportSortEntry *entries = malloc((size_t)(n > 0 ? n : 1) * sizeof(ReportSortEntry));
+    ParkingSpace **spaces = malloc((size_t)(n > 0 ? n : 1) * sizeof(ParkingSpace*));
+    if (!entries || !spaces) {
+        logError(" Failed to allocate a report of %d spaces.\n", n);
+        free(entries); free(spaces);
+        return false;
+    }
+    for (int i = 0; i < n; i++) {
+        ParkingSpace *ps = &table->spaces[i];
+        entries[i] = (ReportSortEntry){ps, ps->total_revenue, reportCountRank(ps->occupancy_count), i};
+    }
+    if (!sortReportEntries(entries, n, sortType)) {
+        logError(" Failed to allocate a report of %d spaces.\n", n);
+        free(entries); free(spaces);
+        return false;
+    }
+    for (int i = 0; i < n; i++) spaces[i] = (ParkingSpace*)entries[i].item;
+    free(entries);
+    report->spaces = spaces;
+    report->count = n;
+    return true;
+}
+
+void freeVehicleReport(VehicleReport *report) {
+    free(report->vehicles);
+    report->vehicles = NULL;
+    report->count = 0;
+}
+
+void freeSpaceReport(SpaceReport *report) {
+    free(report->spaces);
+    report->spaces = NULL;
+    report->count = 0;
+}
+
+// --- Memory Management ---
+// Frees what a node owns outside its slab: separately allocated keys and, for leaves, the data
+void releaseNodeContents(BPlusTreeNode *node) {
+    BPlusTree *tree = node->tree;
+    // Free separately allocated keys (inline keys live in the node block)
+    for (int i = 0; i < node->n; i++) {
+        nodeKeyRelease(node, i);
+    }
+    if (node->is_leaf && tree->free_data) {
+        // Free data pointed to by the leaf
+        for (int i = 0; i < node->n; i++) {
+            if (node->node_type.leaf.data_pointers[i]) {
+               tree->free_data(node->node_type.leaf.data_pointers[i]);
+           }
+        }
+    }
+}
+
+void destroyBPlusTree(BPlusTree *tree) {
+    if (tree) {
+        // Nodes only need visiting when they own heap memory; the walk goes over the
+        // arena chunks, not the tree, and the slabs themselves are freed chunk by chunk
+        bool owns_keys = !tree->inline_keys && tree->free_key;
+        if (owns_keys || tree->free_data) {
+            size_t header = roundUpToCacheLine(sizeof(NodeArenaChunk));
+            for (NodeArenaChunk *chunk = tree->arena.chunks; chunk; chunk = chunk->next) {
+                for (int i = 0; i < chunk->used; i++) {
+                    BPlusTreeNode *node = (BPlusTreeNode*)((unsigned char*)chunk + header + (size_t)i * tree->arena.slab_size);
+                    if (node->n >= 0) releaseNodeContents(node); // n == -1: slab on the free list
+                }
+            }
+        }
+        destroyBPlusTree(tree->amount_index); // Safe even if NULL; it does not own the vehicles
+        nodeArenaRelease(&tree->arena);
+        free(tree); // Free the tree structure itself
+    }
+}
+
+
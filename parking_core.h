@@ -0,0 +1,630 @@
+// parking_core.h - Smart Car Parking System engine (libparking)
+//
+// Vehicle/space records, the B+ tree and space table they live in, the lot configuration and the
+// gate operations. Everything here takes its state as explicit arguments and reads nothing from
+// stdin; the interactive menu, batch replay and benchmarks in smart_parking_system.c are front
+// ends built on it. Build the library with
+//   gcc -O2 -c parking_core.c -o parking_core.o && ar rcs libparking.a parking_core.o
+// and link front ends with -L. -lparking -pthread -lm.
+
+#ifndef PARKING_CORE_H
+#define PARKING_CORE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <stdbool.h>
+#include <math.h> // For ceil, fmax
+#include <ctype.h> // For isspace 
+#include <stdint.h> // For uint64_t plate keys
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define PARKING_X86_SIMD 1 // SSE2/AVX2 node search kernels, picked at runtime via CPUID
+#else
+#define PARKING_X86_SIMD 0
+#endif
+
+#define DEFAULT_LOT_SIZE 50 // Used when the config file is missing or has no lot_size
+#define MAX_LOT_SIZE 1000000 // Sanity cap for lot_size read from the config file
+#define MIN_DEGREE 3 // Example minimum degree for B+ Tree (Order M=2*t)
+#define CACHE_LINE_SIZE 64 // Alignment of each node's key/pointer block
+#define NODE_ARENA_MIN_CHUNK 16   // Slabs in a tree's first arena chunk
+#define NODE_ARENA_MAX_CHUNK 4096 // Chunk growth stops doubling here
+#define BULK_LOAD_FILL_FACTOR 0.9 // Leaf/internal fill used when bulk-building trees at load (leaves room for new inserts)
+#define INPUT_FILENAME "file.txt"
+#define OUTPUT_FILENAME "output.txt"
+#define SNAPSHOT_MAGIC "PKSNAPSH" // 8 bytes, no terminator stored
+#define SNAPSHOT_VERSION 1 // Bump whenever SnapshotHeader or a stored structure changes
+#define CONFIG_FILENAME "parking.conf" // Lot size and tier ranges (override with --config <file>)
+#define ARCHIVE_FILENAME "archive.txt" // Vehicles evicted by the archival policy, appended (override with --archive <file>)
+#define ARCHIVE_SWEEP_INTERVAL 3600 // Seconds of clock time between archival sweeps
+#define ARCHIVE_HEADER "Vehicle_Number\tOwner_Name\tMembership\tArrival\tLast_Departure\tParkings_Done\tTotal_Hours\tAmount_Paid\tArchived_At\n"
+#define LOAD_MAX_THREADS 64 // Upper bound for the parallel loader
+#define LOAD_MIN_CHUNK_BYTES (1 << 20) // Automatic thread count: at least this much input per thread
+#define DATE_CACHE_SIZE 4096 // Per-thread local-midnight offset cache, one entry per civil date: ~11 years without collisions
+#define LOG_RING_DEFAULT_BYTES (1 << 20) // Async log ring capacity
+#define LOG_LINE_MAX 1024 // Lines up to this length are formatted on the stack
+#define LOG_SINK_BUFFER_BYTES (1 << 16) // stdio buffer given to outputFile while the log writer runs
+
+// --- Global Output File Pointer ---
+// Diagnostic log shared by the library and the front end (defined in parking_core.c). It must be
+// a valid stream before any library call; point it at /dev/null to silence the library.
+extern FILE *outputFile;
+
+// --- Log Writer ---
+// Everything written to outputFile goes through logPrintf. Until logStart is called that is a
+// plain vfprintf. Once started, the caller formats the line on its own stack and copies it into a
+// lock-free ring buffer (producers only serialize among themselves on a spin flag), and a
+// background thread drains the ring to outputFile with large fwrite calls. The flush policy
+// decides when the thread wakes: after every operation, every interval_ms, or once size_bytes
+// are pending. logFlush blocks until everything logged so far has been written and flushed.
+typedef enum {
+    LOG_FLUSH_PER_OP, // logOpEnd wakes the writer (the caller does not wait for the write)
+    LOG_FLUSH_TIME,   // The writer drains every interval_ms
+    LOG_FLUSH_SIZE    // The writer drains when size_bytes are pending
+} LogFlushMode;
+
+typedef struct {
+    LogFlushMode mode;
+    int interval_ms;   // LOG_FLUSH_TIME
+    size_t size_bytes; // LOG_FLUSH_SIZE, capped at half the ring
+    size_t ring_bytes; // Ring capacity, rounded up to a power of two (0 = LOG_RING_DEFAULT_BYTES)
+} LogFlushPolicy;
+
+// --- Log Levels ---
+// Diagnostics are logged through logError..logTrace. A message is written only if its level is
+// at or below both the compile-time ceiling PARKING_LOG_LEVEL (e.g. -DPARKING_LOG_LEVEL=LOG_WARN
+// removes INFO and below from the binary) and the runtime threshold logLevel (--log-level).
+// A disabled message costs one integer compare; its arguments are not evaluated.
+// Reports and receipts the user asked for go through logPrintf directly and are never filtered.
+typedef enum {
+    LOG_ERROR, // Operation failed or data is inconsistent
+    LOG_WARN,  // Bad input that was skipped or corrected, lot full
+    LOG_INFO,  // Gate narrative: entries, exits, load progress (default threshold)
+    LOG_DEBUG, // Per-probe detail such as the findAvailableSpace tier searches
+    LOG_TRACE  // Finer detail for debugging the engine
+} LogLevel;
+
+#ifndef PARKING_LOG_LEVEL
+#define PARKING_LOG_LEVEL LOG_TRACE
+#endif
+
+extern LogLevel logLevel; // Runtime threshold, LOG_INFO by default
+
+#define LOG_AT(level, ...) do { \
+        if ((level) <= PARKING_LOG_LEVEL && (level) <= logLevel) logPrintf(__VA_ARGS__); \
+    } while (0)
+#define logError(...) LOG_AT(LOG_ERROR, __VA_ARGS__)
+#define logWarn(...)  LOG_AT(LOG_WARN, __VA_ARGS__)
+#define logInfo(...)  LOG_AT(LOG_INFO, __VA_ARGS__)
+#define logDebug(...) LOG_AT(LOG_DEBUG, __VA_ARGS__)
+#define logTrace(...) LOG_AT(LOG_TRACE, __VA_ARGS__)
+
+// --- Vehicle Data ---
+typedef enum {
+    NO_MEMBERSHIP,
+    PREMIUM,
+    GOLD
+} MembershipType;
+
+extern const char* membership_strings[]; // Indexed by MembershipType
+
+typedef struct {
+    char vehicle_number[15]; // Key for B+ Tree (will be stored separately)
+    char owner_name[50];
+    time_t arrival_time;    
+    time_t last_departure_time; 
+    MembershipType membership;
+    double total_parking_hours; 
+    int num_parkings;        
+    double total_amount_paid; 
+    int current_parking_space_id; // -1 if not parked, otherwise 1..lot size
+} Vehicle;
+
+// Vehicle number packed into a fixed-width key: the plate is zero-padded to 16 bytes and read as
+// two big-endian 64-bit words, so integer order of (hi, lo) equals strcmp order of the plate
+#define PLATE_KEY_SIZE 16
+typedef struct {
+    uint64_t hi; // Bytes 0-7 of the padded plate
+    uint64_t lo; // Bytes 8-15 of the padded plate
+} PlateKey;
+
+// Amount index key: orders vehicles by total_amount_paid descending, then by plate, which is the
+// order of the amount report. NaN amounts are stored as -INFINITY and -0.0 as 0.0, so the order
+// stays total and matches the order of amountOrderBits.
+typedef struct {
+    double amount;
+    PlateKey plate;
+} AmountKey;
+
+typedef struct {
+    AmountKey key;
+    void *vehicle;
+} AmountIndexEntry; // Index bulk-load staging: radix-sorted by key.amount, plate order kept for ties
+
+// --- Parking Space Data ---
+typedef struct {
+    int space_id; // Key for B+ Tree (will be stored separately)
+    int status;   // 0 = free, 1 = occupied
+    int occupancy_count; 
+    double total_revenue; 
+    char parked_vehicle_num[15]; 
+} ParkingSpace;
+
+// --- B+ Tree Node Structures ---
+
+// Forward declarations
+typedef struct BPlusTreeNode_st BPlusTreeNode;
+typedef struct BPlusTree_st BPlusTree;
+
+// Node structure (can be internal or leaf)
+struct BPlusTreeNode_st {
+    bool is_leaf;
+    int n;          // Number of keys currently stored
+    // Key slots, key_stride bytes each - Size: 2*t-1. Every tree uses fixed-size keys (PlateKey for
+    // vehicles, int for spaces, AmountKey for the amount index), stored inline by value.
+    // The block is cache-line aligned and the child/data pointer array follows it directly.
+    // Node header, keys and pointers all live in one slab handed out by the tree's NodeArena.
+    unsigned char *keys;
+    BPlusTree *tree; // Pointer back to the tree for config (t, compare)
+
+    union {
+        // For internal nodes
+        struct {
+            BPlusTreeNode **C; // Child pointers - Size: 2*t
+        } internal;
+        // For leaf nodes
+        struct {
+            void **data_pointers; // Pointers to actual Vehicle/Space data - Size: 2*t-1
+            BPlusTreeNode *next; // Pointer to the next leaf node
+            BPlusTreeNode *prev; // Pointer to the previous leaf node
+        } leaf;
+    } node_type;
+};
+
+// Node arena: nodes are carved out of large cache-line aligned chunks as fixed-size slabs
+// (header + key slots + pointers). Released slabs go on a free list (linked through
+// node_type.leaf.next, marked with n == -1) and the whole arena is freed chunk by chunk.
+typedef struct NodeArenaChunk_st {
+    struct NodeArenaChunk_st *next;
+    int used;     // Slabs handed out from this chunk so far
+    int capacity; // Slabs in this chunk
+} NodeArenaChunk;
+
+typedef struct {
+    size_t slab_size;         // Bytes per node slab, a multiple of CACHE_LINE_SIZE
+    size_t slab_offset;       // Offset of the key block inside a slab (header rounded up)
+    NodeArenaChunk *chunks;   // Most recent chunk first; only it has unused slabs
+    BPlusTreeNode *free_list; // Released slabs, reused before carving new ones
+    int next_capacity;        // Slabs in the next chunk (doubles up to NODE_ARENA_MAX_CHUNK)
+    size_t live_nodes;
+} NodeArena;
+
+// Key layout hint used to pick a specialized node search kernel
+typedef enum {
+    KEY_KIND_GENERIC, // Compare through tree->compare only
+    KEY_KIND_INT,     // Inline int keys (space tree)
+    KEY_KIND_PLATE    // Inline PlateKey keys (vehicle tree)
+} BPlusKeyKind;
+
+// Node search kernel: number of keys < key (or <= key when upper) among the n inline keys
+typedef int (*NodeSearchKernel)(const unsigned char *keys, int n, const void *key, bool upper);
+
+// Tree structure
+struct BPlusTree_st {
+    BPlusTreeNode *root;
+    int t; // Minimum degree (defines node size)
+    // Comparison function pointer: returns <0 if key1<key2, 0 if key1==key2, >0 if key1>key2
+    int (*compare)(const void *key1, const void *key2);
+    void (*free_key)(void *key);
+    void (*free_data)(void *data);
+    BPlusTreeNode *first_leaf; // Pointer to the start of the leaf list (for easier traversal)
+    size_t key_size; // Size of the key type (0 = variable-length string keys)
+    bool inline_keys; // key_size > 0: key values are copied into the node instead of referenced
+    size_t key_stride; // Bytes per key slot: key_size when inline, sizeof(void*) otherwise
+    size_t key_block_size; // Bytes of a node's key array, rounded up to CACHE_LINE_SIZE
+    NodeSearchKernel node_search; // Specialized search for inline keys, NULL = compare-based
+    const char *node_search_name; // Kernel description for diagnostics
+    NodeArena arena; // Owns every node of this tree
+    BPlusTree *amount_index; // Vehicle trees only: optional AmountKey -> Vehicle* index (buildAmountIndex), NULL if none
+    int amount_entries; // Entries in amount_index, which sizes its arena headroom
+};
+
+// Position in a tree's leaf chain: entry 'pos' of 'leaf'. leaf is NULL once a scan runs off either
+// end. A cursor owns nothing and stays valid until the tree is next modified.
+typedef struct {
+    BPlusTree *tree;
+    BPlusTreeNode *leaf;
+    int pos;
+} BPlusCursor;
+
+// rangeScan callback: one entry's key and data. Returning false ends the scan.
+typedef bool (*BPlusVisitor)(const void *key, void *data, void *ctx);
+
+// --- Clock ---
+// Where "now" comes from for the front ends and the initial load (the gate operations themselves
+// take explicit times). WALL reads time(NULL); FIXED always returns the same instant, which makes
+// fees and output reproducible; EVENT returns the timestamp of the last event fed to it, so a
+// replay runs as fast as the events can be processed instead of at wall-clock speed.
+typedef enum {
+    PARKING_CLOCK_WALL,
+    PARKING_CLOCK_FIXED,
+    PARKING_CLOCK_EVENT
+} ParkingClockMode;
+
+typedef struct {
+    ParkingClockMode mode;
+    time_t now; // FIXED: the instant returned; EVENT: last event timestamp (0 until the first event)
+} ParkingClock;
+
+extern ParkingClock parkingClock; // Process-wide clock, WALL unless a front end selects another
+
+// --- Lot Configuration ---
+// Lot size and the space ID range searched for each tier. Allocation tries GOLD, then PREMIUM,
+// then general ranges in that order (a tier also falls through to the ranges after it).
+typedef struct {
+    int lot_size;
+    int gold_first, gold_last;
+    int premium_first, premium_last;
+    int general_first, general_last;
+} LotConfig;
+
+// --- Parking Space Table ---
+// Space IDs are dense (1..count), so spaces live in one flat array indexed by space_id and the
+// gate path finds a space with a bounds-checked array access. The B+ tree is only an optional
+// ordered view over the same records (its data pointers point into the array, it owns nothing).
+// A free bitmap (bit space_id - 1 set = free) mirrors every status change, so allocation is a
+// masked scan over 64-space words instead of a walk over the spaces themselves. A summary bitmap
+// (bit w set = word w has a free space) lets the scan skip runs of full words 64 at a time:
+// lowest-ID-first allocation packs the start of each tier, so those runs grow with the lot.
+typedef struct {
+    ParkingSpace *spaces; // spaces[space_id - 1]
+    int count;
+    uint64_t *free_bits;  // ceil(count / 64) words; bits past count are always 0
+    int word_count;
+    uint64_t *word_summary; // ceil(word_count / 64) words: bit w set = free_bits[w] != 0
+    LotConfig layout;     // Tier ranges, validated against count
+    BPlusTree *view;      // Ordered view keyed by space_id, NULL when not built
+} SpaceTable;
+
+// --- Vehicle Archival ---
+// A vehicle that is not parked and has had no entry or exit for max_idle seconds is written to the
+// archive file and deleted from the vehicle tree and the amount index. The resident set then
+// follows the active fleet rather than every plate ever seen. An archived vehicle that comes back
+// is registered again as a new vehicle.
+typedef struct {
+    time_t max_idle;       // Inactivity before eviction, 0 = archival off
+    time_t sweep_interval; // Clock time between sweeps
+    time_t last_sweep;     // 0 until the first sweep
+    const char *path;      // Archive file, opened in append mode for each sweep
+} ArchivePolicy;
+
+// --- Binary Snapshot ---
+// A snapshot is the loaded state written as raw arrays, so a restart can skip parsing file.txt:
+//   SnapshotHeader | ParkingSpace[space_count] | Vehicle[vehicle_count] | node slabs[node_count]
+// Vehicles are stored in plate (leaf) order. Node slabs are byte images of the vehicle tree's
+// arena slabs in breadth-first order, with every pointer replaced by a 1-based index: child and
+// leaf next/prev pointers by node index, leaf data pointers by vehicle index, 0 for NULL. Restore
+// maps the file, copies the slabs into one arena chunk and turns the indexes back into pointers.
+// The layout fields must match the running build exactly, otherwise the snapshot is rejected.
+typedef struct {
+    char magic[8];            // SNAPSHOT_MAGIC
+    uint32_t version;         // SNAPSHOT_VERSION
+    uint32_t byte_order;      // 0x01020304 as stored by the writer
+    uint32_t vehicle_size;    // sizeof(Vehicle)
+    uint32_t space_size;      // sizeof(ParkingSpace)
+    uint32_t node_size;       // sizeof(BPlusTreeNode)
+    uint32_t slab_size;       // Vehicle tree arena slab size
+    uint32_t slab_offset;
+    uint32_t key_block_size;
+    uint32_t key_size;
+    int32_t min_degree;
+    LotConfig layout;
+    int64_t space_count;
+    int64_t vehicle_count;
+    int64_t node_count;
+    int64_t root_index;       // 1-based index into the node slabs
+    int64_t first_leaf_index;
+    int64_t saved_at;         // time() when written
+    uint64_t spaces_offset;   // Byte offsets of the three sections
+    uint64_t vehicles_offset;
+    uint64_t nodes_offset;
+    uint64_t file_size;
+} SnapshotHeader;
+
+// --- Structures for Sorting/Reporting 
+// Sorted reports are contiguous pointer arrays, sorted once (no per-record list insertion).
+// sortType 1 sorts by the record's count (num_parkings / occupancy_count), 2 by its amount
+// (total_amount_paid / total_revenue), both descending; 0 keeps leaf order. Equal keys keep
+// leaf order, the same order the old insertion-sorted lists produced.
+typedef struct {
+    Vehicle **vehicles;
+    int count;
+} VehicleReport;
+
+typedef struct {
+    ParkingSpace **spaces;
+    int count;
+} SpaceReport;
+
+// One record during a report sort: the sort key is copied next to the pointer so the sort
+// never dereferences records
+typedef struct {
+    void *item;
+    double amount;   // sortType 2 key
+    uint32_t rank;   // sortType 1 key, mapped so that ascending unsigned order is descending count
+    int position;    // Leaf order, the tie-break
+} ReportSortEntry;
+
+// --- Gate Operation Results ---
+typedef enum {
+    PARK_OK,
+    PARK_ALREADY_PARKED, // Entry: the vehicle already occupies a space
+    PARK_LOT_FULL,       // Entry: no free space in the tiers the vehicle may use
+    PARK_NOT_FOUND,      // Exit: unknown vehicle number
+    PARK_NOT_PARKED,     // Exit: the vehicle is registered but not parked
+    PARK_ERROR           // Invalid arguments, allocation failure or inconsistent space table
+} ParkStatus;
+
+typedef struct {
+    ParkStatus status;
+    bool new_vehicle;       // The vehicle was not registered before this entry
+    int space_id;           // Space assigned (or already occupied / found busy), -1 if none
+    time_t arrival_time;
+    const Vehicle *vehicle; // Registered record, NULL if a new vehicle could not be registered
+} EntryResult;
+
+typedef struct {
+    ParkStatus status;
+    int space_id;           // Space freed by this exit
+    time_t arrival_time;
+    time_t departure_time;
+    double duration_hours;
+    double fee;
+    MembershipType old_membership; // Before this stay's hours were added
+    MembershipType membership;     // After; the fee uses this one
+    const Vehicle *vehicle; // Updated record with the all-time totals, NULL if not found
+} ExitResult;
+
+typedef struct {
+    int total, occupied, free;
+    int gold_free, premium_free, general_free; // Free spaces inside each tier's configured range
+} OccupancyResult;
+
+// --- Staging record for the initial file load ---
+typedef enum {
+    RECORD_PARSED,
+    RECORD_TOO_FEW_FIELDS,
+    RECORD_BAD_PLATE
+} RecordStatus;
+
+typedef struct {
+    char vehicle_number[15];
+    char owner_name[50];
+    time_t arrival_time;    // 0 if "none" or unparseable
+    time_t departure_time;  // 0 if "none" or unparseable
+    bool departure_none;    // Dep_Date column was "none" (still parked)
+    MembershipType membership;
+    int space_id;
+    int parkings_done;
+    double amount_paid;
+    int occupancy;          // For the space
+    double max_revenue;     // For the space
+    int line_num;
+    Vehicle *vehicle;       // Shared by every line with the same plate
+    bool is_repeat;         // Plate already seen on an earlier line (or already in the tree)
+    RecordStatus status;    // RECORD_PARSED, or why the line is skipped
+    int field_count;        // Fields found on the line
+} InitialRecord;
+
+// One newline-aligned slice of file.txt for a loader thread. Line numbers in its records are
+// relative to the slice until the merge adds first_line.
+typedef struct {
+    const char *begin, *end;
+    int first_line;           // File line number before the slice's first line
+    int lines;                // Lines in the slice, including blank ones
+    InitialRecord *records;   // Every non-blank line, in file order
+    int count;
+    InitialRecord **sorted;   // Parsed records ordered by plate, then line
+    int sorted_count;
+    int skipped;              // Records with a status other than RECORD_PARSED
+    bool failed;              // Allocation failure
+} LoadChunk;
+
+// --- Mapped input file ---
+// The initial load maps file.txt read-only and parses it in place, so fields are spans into the
+// mapping rather than NUL-terminated copies.
+typedef struct {
+    const char *data; // File contents, not NUL-terminated; NULL for an empty file
+    size_t size;
+    bool mapped;      // false: data is a heap copy (the file could not be mapped)
+} MappedFile;
+
+typedef struct {
+    const char *p; // Start of the field inside the mapped file
+    size_t len;
+} TextSpan;
+
+
+// --- Helper Function Prototypes ---
+void safe_strcpy(char *dest, const char *src, size_t dest_size);
+void formatTime(time_t rawtime, char* buffer, size_t buffer_size);
+time_t parseDateTimeString(const char* date_str, const char* time_str, const char* ampm_str);
+time_t parseUserInputDateTime(const char* datetime_str); 
+int64_t daysFromCivil(int year, int month, int day); // Days since 1970-01-01 (proleptic Gregorian)
+int daysInMonth(int year, int month);
+time_t mktimeLocal(int year, int month, int day, int hour, int min, int sec); // mktime with tm_isdst = -1
+time_t localDateTimeToEpoch(int year, int month, int day, int hour, int min, int sec); // Same result as mktimeLocal
+char* trim_whitespace(char *str);
+int compare_vehicle_keys(const void *key1, const void *key2); 
+int compare_space_keys(const void *key1, const void *key2);   
+int compare_amount_keys(const void *key1, const void *key2);
+void free_vehicle_key(void *key); 
+void free_space_key(void *key);   
+void free_vehicle_data(void *data); 
+void free_space_data(void *data);   
+PlateKey makePlateKey(const char* vnum); // Pack a vehicle number into a PlateKey
+void* create_vehicle_key(const char* vnum); // Allocate a packed PlateKey (only for keys the tree will own)
+void* create_space_key(int space_id); // Allocate and store int key
+
+// --- B+ Tree Core Function Prototypes ---
+BPlusTreeNode* createBPlusTreeNode(BPlusTree *tree, bool is_leaf);
+void releaseBPlusTreeNode(BPlusTreeNode *node); // Frees one node's keys/data and returns its slab
+void nodeArenaInit(NodeArena *arena, size_t block_size);
+BPlusTreeNode* nodeArenaAlloc(NodeArena *arena);
+void nodeArenaFree(NodeArena *arena, BPlusTreeNode *node);
+void nodeArenaRelease(NodeArena *arena); // Frees every chunk at once
+bool nodeArenaReserve(NodeArena *arena, int slabs); // Next 'slabs' allocations come from one chunk
+size_t nodeArenaSpareSlabs(const NodeArena *arena); // Slabs available without allocating
+size_t roundUpToCacheLine(size_t bytes);
+const void* nodeKeyAt(const BPlusTreeNode *node, int i); // Key value at slot i
+void nodeKeyStore(BPlusTreeNode *node, int i, void *key); // Takes ownership of key
+void* nodeKeyTake(BPlusTreeNode *node, int i); // Hands the key at slot i to the caller
+void nodeKeysMove(BPlusTreeNode *dst, int dst_index, BPlusTreeNode *src, int src_index, int count);
+void nodeKeyRelease(BPlusTreeNode *node, int i);
+void nodeKeyCopy(BPlusTreeNode *dst, int dst_index, const BPlusTreeNode *src, int src_index); // Separator copy into an occupied slot
+BPlusTree* createBPlusTree(int t, size_t key_size,   int (*compare)(const void*, const void*),
+                           void (*free_key)(void*),   void (*free_data)(void*));
+void* searchBPlusTree(BPlusTree *tree, const void *key); // Returns data pointer or NULL; key is only borrowed
+BPlusTreeNode* findLeaf(BPlusTreeNode *node, const void *key);
+int nodeLowerBound(const BPlusTreeNode *node, const void *key, bool upper); // Binary search within one node
+void setBPlusTreeKeyKind(BPlusTree *tree, BPlusKeyKind kind); // Selects SIMD/scalar node search
+int nodeSearchIntScalar(const unsigned char *keys, int n, const void *key, bool upper);
+int nodeSearchPlateScalar(const unsigned char *keys, int n, const void *key, bool upper);
+#if PARKING_X86_SIMD
+int nodeSearchIntSse2(const unsigned char *keys, int n, const void *key, bool upper);
+int nodeSearchIntAvx2(const unsigned char *keys, int n, const void *key, bool upper);
+int nodeSearchPlateAvx2(const unsigned char *keys, int n, const void *key, bool upper);
+#endif
+void insertBPlusTree(BPlusTree *tree, void *key, void *data_ptr);
+void insertIntoLeaf(BPlusTreeNode *leaf, void *key, void *data_ptr);
+void insertIntoParent(BPlusTreeNode *node, void *key, BPlusTreeNode *right_child); 
+void insertIntoInternal(BPlusTreeNode *node, void *key, BPlusTreeNode *right_child); // Helper for insertIntoParent
+bool deleteBPlusTree(BPlusTree *tree, const void *key, void **data_out); // data_out NULL: data released with free_data
+void* duplicateKey(BPlusTree *tree, const void *key); // Separator copy for internal nodes
+int bulkLoadNodeCapacity(int max_entries, int min_entries, double fill_factor);
+int bulkLoadNodeCount(int entries, int capacity, int min_entries); // Nodes for one bulk-loaded level
+int bplusTreeMaxNodes(int t, int count); // Most nodes a tree of 'count' keys can hold
+bool bulkLoadBPlusTree(BPlusTree *tree, void **keys, void **data_ptrs, int count, double fill_factor); // Keys must be sorted
+
+// --- Specialized B+ Tree Instantiations ---
+// Same trees, searched/inserted with the key type fixed at compile time (see bplustree_template.h,
+// instantiated in parking_core.c): PlateTree for the vehicle tree, AmountTree (insert only, it is
+// range-scanned) for the vehicle tree's amount index. The space view only uses the generic API.
+void* searchPlateTree(BPlusTree *tree, PlateKey key);
+bool insertPlateTree(BPlusTree *tree, PlateKey key, void *data_ptr);
+bool insertAmountTree(BPlusTree *tree, AmountKey key, void *data_ptr);
+Vehicle* lookupVehicle(BPlusTree *vehicleTree, const char *vehicle_num); // Packs the plate on the stack, no allocation
+
+// --- Leaf Cursor Function Prototypes ---
+// Each positioning call returns cursorValid() of the result
+bool cursorFirst(BPlusCursor *cursor, BPlusTree *tree);
+bool cursorLast(BPlusCursor *cursor, BPlusTree *tree);
+bool cursorSeek(BPlusCursor *cursor, BPlusTree *tree, const void *key); // First entry >= key; key is only borrowed
+bool cursorNext(BPlusCursor *cursor);
+bool cursorPrev(BPlusCursor *cursor);
+bool cursorValid(const BPlusCursor *cursor);
+const void* cursorKey(const BPlusCursor *cursor); // NULL when not valid
+void* cursorData(const BPlusCursor *cursor); // NULL when not valid
+int rangeScan(BPlusTree *tree, const void *lo, const void *hi, BPlusVisitor visit, void *ctx); // Keys in [lo, hi], NULL = open end
+
+// --- Log Writer Function Prototypes ---
+void logPrintf(const char *format, ...) __attribute__((format(printf, 1, 2)));
+bool logStart(const LogFlushPolicy *policy); // Starts the writer thread on outputFile (call before any output)
+void logOpEnd(); // Operation boundary: wakes the writer under LOG_FLUSH_PER_OP
+void logFlush(); // Blocks until all logged output is written and flushed
+void logStop(); // Drains and joins the writer; outputFile stays open
+bool parseLogFlushSpec(const char *spec, LogFlushPolicy *policy); // "op", "time:<ms>" or "size:<bytes>"
+bool parseLogLevel(const char *name, LogLevel *level); // "error", "warn", "info", "debug" or "trace"
+
+// --- Clock Function Prototypes ---
+time_t clockNow(const ParkingClock *clock);
+void setClockWall(ParkingClock *clock);
+void setClockFixed(ParkingClock *clock, time_t now);
+void setClockEvent(ParkingClock *clock);
+void clockObserveEvent(ParkingClock *clock, time_t event_time); // Advances an EVENT clock, no-op otherwise
+bool parseClockSpec(const char *spec, ParkingClock *clock); // "wall", "event" or "fixed:YYYY-MM-DD HH:MM:SS"
+
+// --- Lot Configuration Function Prototypes ---
+void setDefaultLotConfig(LotConfig *config, int lot_size); // Tiers 1/11/21 up to lot_size
+bool loadLotConfig(const char *path, LotConfig *config); // false if the file is missing
+bool parseTierRange(const char *value, int lot_size, int *first, int *last);
+
+// --- Space Table Function Prototypes ---
+bool initSpaceTable(SpaceTable *table, const LotConfig *config); // All spaces free
+ParkingSpace* lookupSpace(const SpaceTable *table, int space_id); // NULL if out of range
+void setSpaceStatus(SpaceTable *table, ParkingSpace *ps, int status); // Keeps the free bitmap in sync
+bool buildSpaceTreeView(SpaceTable *table); // Optional ordered B+ tree over the table
+void destroySpaceTable(SpaceTable *table);
+
+// --- Parking System Logic Function Prototypes ---
+void updateMembership(Vehicle *v);
+bool loadInitialData(BPlusTree *vehicleTree, SpaceTable *spaces); // file.txt, automatic thread count
+bool loadInitialDataFrom(BPlusTree *vehicleTree, SpaceTable *spaces, const char *path, int threads); // threads <= 0: automatic; false on failure
+int chooseLoadThreads(size_t input_bytes, int requested);
+void* loadChunkWorker(void *arg); // pthread entry: parse and sort one LoadChunk
+void logSkippedRecord(const InitialRecord *rec, int line_num);
+int compare_initial_records(const void *a, const void *b);
+bool mapInputFile(const char *path, MappedFile *file); // mmap, or read into memory if that fails
+void unmapInputFile(MappedFile *file);
+TextSpan trimSpan(TextSpan s);
+bool spanEquals(TextSpan s, const char *literal, bool ignore_case);
+void copySpan(TextSpan s, char *buffer, size_t buffer_size); // NUL-terminated copy for libc fallbacks
+int spanDigits(const char *p, int count); // Fixed-width digit field, -1 if not all digits
+int parseSpanInt(TextSpan s); // atoi semantics
+double parseSpanDecimal(TextSpan s); // atof semantics
+time_t parseSpanDateTime(TextSpan date, TextSpan time, TextSpan ampm); // parseDateTimeString semantics
+bool parseInitialRecordSpan(const char *line, const char *end, int line_num, InitialRecord *rec);
+void applyInitialRecord(const InitialRecord *rec, SpaceTable *spaces);
+int findAvailableSpace(const SpaceTable *spaces, MembershipType membership);
+int findSpaceInRange(const SpaceTable *spaces, int start_id, int end_id); // Helper
+int findNonEmptyWord(const SpaceTable *spaces, int from_w, int to_w); // Summary bitmap scan
+double calculateParkingFee(double hours, MembershipType membership);
+
+// --- Amount Index Function Prototypes ---
+AmountKey makeAmountKey(const Vehicle *v);
+uint64_t amountOrderBits(double amount); // Descending amount -> ascending unsigned
+void radixSortAmountEntries(AmountIndexEntry *entries, AmountIndexEntry *scratch, int n); // Stable
+bool buildAmountIndex(BPlusTree *vehicleTree); // (Re)builds vehicleTree->amount_index from the vehicles
+bool updateAmountIndex(BPlusTree *vehicleTree, Vehicle *v, double old_amount); // After total_amount_paid changed
+bool reserveAmountIndexHeadroom(BPlusTree *vehicleTree); // Slabs for the index's worst-case shape
+int scanAmountIndex(BPlusTree *vehicleTree, double min_amount, double max_amount, BPlusVisitor visit, void *ctx); // Descending by amount
+
+// --- Snapshot Function Prototypes ---
+bool saveSnapshot(const char *path, BPlusTree *vehicleTree, const SpaceTable *spaces); // Written atomically (temp file + rename)
+bool loadSnapshot(const char *path, BPlusTree *vehicleTree, SpaceTable *spaces); // vehicleTree must be empty; spaces is rebuilt from the snapshot
+
+// --- Vehicle Archival Function Prototypes ---
+time_t vehicleLastActivity(const Vehicle *v); // Later of arrival and last departure
+bool vehicleIsInactive(const Vehicle *v, time_t now, time_t max_idle); // Never true while parked or with no recorded times
+bool writeArchiveRecord(FILE *archive, const Vehicle *v, time_t archived_at); // One ARCHIVE_HEADER line
+int archiveInactiveVehicles(BPlusTree *vehicleTree, time_t now, time_t max_idle, FILE *archive); // Evicted count, -1 on error
+int runArchivePolicy(ArchivePolicy *policy, BPlusTree *vehicleTree, time_t now); // Sweeps when due; evicted count
+
+// --- Gate Operation Function Prototypes ---
+EntryResult vehicleEntry(BPlusTree *vehicleTree, SpaceTable *spaces, const char *vehicle_num,
+                         const char *owner_name, time_t arrival_time); // owner_name only used for new vehicles
+ExitResult vehicleExit(BPlusTree *vehicleTree, SpaceTable *spaces, const char *vehicle_num, time_t departure_time);
+OccupancyResult queryOccupancy(const SpaceTable *spaces);
+int countFreeSpaces(const SpaceTable *spaces, int first_id, int last_id);
+
+// --- Report Sorting Function Prototypes ---
+uint32_t reportCountRank(int count); // Descending count -> ascending unsigned
+void radixSortReportEntries(ReportSortEntry *entries, ReportSortEntry *scratch, int n); // Stable, by rank
+bool reportEntryBefore(const ReportSortEntry *a, const ReportSortEntry *b);
+void swapReportEntries(ReportSortEntry *a, ReportSortEntry *b);
+void heapSortReportEntries(ReportSortEntry *entries, int n);
+void introSortReportRange(ReportSortEntry *entries, int lo, int hi, int depth);
+void introSortReportEntries(ReportSortEntry *entries, int n); // By amount (desc), then position
+bool sortReportEntries(ReportSortEntry *entries, int n, int sortType);
+bool buildVehicleReport(BPlusTree *tree, int sortType, VehicleReport *report);
+bool buildSpaceReport(const SpaceTable *table, int sortType, SpaceReport *report);
+void freeVehicleReport(VehicleReport *report);
+void freeSpaceReport(SpaceReport *report);
+
+// --- Memory Management Function Prototypes ---
+void releaseNodeContents(BPlusTreeNode *node);
+void destroyBPlusTree(BPlusTree *tree);
+
+#endif // PARKING_CORE_H